@@ -0,0 +1,324 @@
+#include <errno.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "alloc.h"
+
+#ifdef ALLOC_WRAP
+// Enlace estático: libc.a ya define malloc y compañía, así que el Makefile
+// enlaza con `ld --wrap=malloc ...' y los llamados llegan a __wrap_malloc
+#define HOOK(name) __wrap_##name
+#define LIBC(name) __real_##name
+#else
+#define HOOK(name) name
+#define LIBC(name) __libc_##name
+#endif
+
+void *HOOK(malloc)(size_t size);
+void *HOOK(calloc)(size_t n, size_t size);
+void *HOOK(realloc)(void *ptr, size_t size);
+void *HOOK(reallocarray)(void *ptr, size_t n, size_t size);
+void *HOOK(memalign)(size_t alignment, size_t size);
+void *HOOK(aligned_alloc)(size_t alignment, size_t size);
+int HOOK(posix_memalign)(void **out, size_t alignment, size_t size);
+void *HOOK(valloc)(size_t size);
+void *HOOK(pvalloc)(size_t size);
+void HOOK(free)(void *ptr);
+
+// Implementación de glibc, a la que delegan los reemplazos de este archivo
+void *LIBC(malloc)(size_t size);
+void *LIBC(calloc)(size_t n, size_t size);
+void *LIBC(realloc)(void *ptr, size_t size);
+void *LIBC(memalign)(size_t alignment, size_t size);
+void LIBC(free)(void *ptr);
+
+#define ARENA_RESERVE (64UL << 20)  // memoria virtual reservada para la arena
+#define ARENA_KEEP (1UL << 20)      // lo que sigue mapeado después de un reset
+#define ARENA_ALIGN 16              // la alineación que garantiza malloc
+#define ARENA_HEADER 16             // cada bloque lleva su tamaño adelante
+
+struct phase_stats_s {
+    uint64_t mallocs;   // pedidos (malloc, calloc, realloc, memalign)
+    uint64_t frees;
+    uint64_t bytes;     // bytes pedidos
+    uint64_t peak;      // máximo de bytes en uso visto en la fase
+};
+
+// "En uso" cuenta lo que ocupa cada bloque sin su cabecera: en el heap
+// malloc_usable_size(), en la arena el tamaño redondeado a ARENA_ALIGN
+static struct phase_stats_s stats[ALLOC_PHASES];
+static uint64_t live = 0; // bytes en uso en todo el proceso
+static const char *phase_names[ALLOC_PHASES] = {"other", "parse", "expand", "build", "execute"};
+
+static __thread alloc_phase_t current = ALLOC_OTHER;
+static __thread bool arena_on = false;
+
+// La arena la usa un solo hilo por vez (el que la prendió); los demás sólo
+// consultan si un puntero cae dentro de ella
+static char *arena_base = NULL;
+static size_t arena_used = 0;         // bytes ocupados desde el último reset
+static size_t arena_last = SIZE_MAX;  // offset del último bloque, que puede crecer en su lugar
+static uint64_t arena_bytes = 0;      // bytes en uso en la arena desde el último reset
+static size_t arena_peak = 0;         // máximo de arena_used entre dos resets
+static uint64_t arena_resets = 0;
+
+static void account_alloc(size_t size, size_t used) { // `size' pedidos, que ocupan `used'
+    struct phase_stats_s *s = &stats[current];
+    __atomic_fetch_add(&s->mallocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s->bytes, size, __ATOMIC_RELAXED);
+    uint64_t now = __atomic_add_fetch(&live, used, __ATOMIC_RELAXED);
+    if (now > __atomic_load_n(&s->peak, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&s->peak, now, __ATOMIC_RELAXED);
+    }
+}
+
+static void account_free(size_t size) {
+    __atomic_fetch_add(&stats[current].frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&live, size, __ATOMIC_RELAXED);
+}
+
+static bool in_arena(const void *ptr) {
+    return arena_base != NULL && (const char *)ptr >= arena_base &&
+           (const char *)ptr < arena_base + ARENA_RESERVE;
+}
+
+static size_t arena_size(const void *ptr) { // tamaño pedido para un bloque de la arena
+    return *(const size_t *)((const char *)ptr - ARENA_HEADER);
+}
+
+static size_t arena_usable(size_t size) { // lo que ocupa en la arena, sin la cabecera
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static size_t arena_round(size_t size) {
+    return ARENA_HEADER + arena_usable(size);
+}
+
+static void *arena_alloc(size_t size) {
+    if (size > ARENA_RESERVE || arena_round(size) > ARENA_RESERVE - arena_used) {
+        return NULL; // no entra: va a malloc
+    }
+    char *block = arena_base + arena_used;
+    *(size_t *)block = size;
+    arena_last = arena_used;
+    arena_used += arena_round(size);
+    arena_bytes += arena_usable(size);
+    if (arena_used > arena_peak) {
+        arena_peak = arena_used;
+    }
+    account_alloc(size, arena_usable(size));
+    return block + ARENA_HEADER;
+}
+
+static bool arena_grow(void *ptr, size_t size) { // agranda el último bloque sin moverlo
+    size_t offset = (size_t)((char *)ptr - arena_base) - ARENA_HEADER;
+    if (offset != arena_last || size > ARENA_RESERVE || arena_round(size) > ARENA_RESERVE - offset) {
+        return false;
+    }
+    size_t old = arena_size(ptr);
+    *(size_t *)(arena_base + offset) = size;
+    arena_used = offset + arena_round(size);
+    arena_bytes += arena_usable(size) - arena_usable(old);
+    if (arena_used > arena_peak) {
+        arena_peak = arena_used;
+    }
+    account_alloc(size - old, arena_usable(size) - arena_usable(old));
+    return true;
+}
+
+void *HOOK(malloc)(size_t size) {
+    if (arena_on) {
+        void *ptr = arena_alloc(size);
+        if (ptr != NULL) {
+            return ptr;
+        }
+    }
+    void *ptr = LIBC(malloc)(size);
+    if (ptr != NULL) {
+        account_alloc(size, malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *HOOK(calloc)(size_t n, size_t size) {
+    size_t total;
+    if (__builtin_mul_overflow(n, size, &total)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (arena_on) {
+        void *ptr = arena_alloc(total);
+        if (ptr != NULL) {
+            return memset(ptr, 0, total); // la arena se reusa después de cada reset
+        }
+    }
+    void *ptr = LIBC(calloc)(n, size);
+    if (ptr != NULL) {
+        account_alloc(total, malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void HOOK(free)(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (in_arena(ptr)) { // se libera con alloc_arena_reset()
+        __atomic_fetch_add(&stats[current].frees, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    account_free(malloc_usable_size(ptr));
+    LIBC(free)(ptr);
+}
+
+void *HOOK(realloc)(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return HOOK(malloc)(size);
+    }
+    if (size == 0) {
+        HOOK(free)(ptr);
+        return NULL;
+    }
+    if (in_arena(ptr)) {
+        size_t old = arena_size(ptr);
+        if (size <= old || (arena_on && arena_grow(ptr, size))) {
+            return ptr;
+        }
+        void *copy = HOOK(malloc)(size); // con la arena apagada, el bloque pasa a malloc
+        if (copy != NULL) {
+            memcpy(copy, ptr, old);
+            HOOK(free)(ptr);
+        }
+        return copy;
+    }
+    size_t old = malloc_usable_size(ptr);
+    void *moved = LIBC(realloc)(ptr, size);
+    if (moved != NULL) {
+        account_free(old);
+        account_alloc(size, malloc_usable_size(moved));
+    }
+    return moved;
+}
+
+void *HOOK(reallocarray)(void *ptr, size_t n, size_t size) {
+    // la de glibc llama a su realloc interno, que no conoce la arena
+    size_t total;
+    if (__builtin_mul_overflow(n, size, &total)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return HOOK(realloc)(ptr, total);
+}
+
+// Los pedidos con alineación nunca salen de la arena, pero se cuentan para
+// que free() no descuente memoria que no se sumó
+void *HOOK(memalign)(size_t alignment, size_t size) {
+    void *ptr = LIBC(memalign)(alignment, size);
+    if (ptr != NULL) {
+        account_alloc(size, malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *HOOK(aligned_alloc)(size_t alignment, size_t size) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return HOOK(memalign)(alignment, size);
+}
+
+int HOOK(posix_memalign)(void **out, size_t alignment, size_t size) {
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *ptr = HOOK(memalign)(alignment, size);
+    if (ptr == NULL) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+// Las de glibc no pasan por memalign() de acá, y sus bloques terminan en
+// free(): sin contarlos, el uso se iría por debajo de cero
+void *HOOK(valloc)(size_t size) {
+    return HOOK(memalign)((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+void *HOOK(pvalloc)(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (size > SIZE_MAX - page) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return HOOK(memalign)(page, size == 0 ? page : (size + page - 1) & ~(page - 1));
+}
+
+alloc_phase_t alloc_phase(alloc_phase_t phase) {
+    alloc_phase_t previous = current;
+    current = phase;
+    return previous;
+}
+
+bool alloc_arena(bool on) {
+    bool previous = arena_on;
+    if (on && arena_base == NULL) {
+        void *mem = mmap(NULL, ARENA_RESERVE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem == MAP_FAILED) {
+            return previous; // sin arena: todo sigue en malloc
+        }
+        arena_base = mem;
+    }
+    arena_on = on;
+    return previous;
+}
+
+void alloc_arena_reset(void) {
+    if (arena_base == NULL || arena_used == 0) {
+        return;
+    }
+    if (arena_used > ARENA_KEEP) { // devuelve al sistema lo que usó una línea muy grande
+        madvise(arena_base + ARENA_KEEP, arena_used - ARENA_KEEP, MADV_DONTNEED);
+    }
+    __atomic_fetch_sub(&live, arena_bytes, __ATOMIC_RELAXED);
+    arena_used = 0;
+    arena_last = SIZE_MAX;
+    arena_bytes = 0;
+    arena_resets++;
+}
+
+void alloc_print(FILE *out) {
+    fprintf(out, "%-10s %12s %12s %14s %14s\n", "fase", "pedidos", "liberados", "bytes", "pico en uso");
+    for (unsigned int i = 0; i < ALLOC_PHASES; i++) {
+        struct phase_stats_s s;
+        s.mallocs = __atomic_load_n(&stats[i].mallocs, __ATOMIC_RELAXED);
+        s.frees = __atomic_load_n(&stats[i].frees, __ATOMIC_RELAXED);
+        s.bytes = __atomic_load_n(&stats[i].bytes, __ATOMIC_RELAXED);
+        s.peak = __atomic_load_n(&stats[i].peak, __ATOMIC_RELAXED);
+        fprintf(out, "%-10s %12lu %12lu %14lu %14lu\n", phase_names[i], (unsigned long)s.mallocs,
+                (unsigned long)s.frees, (unsigned long)s.bytes, (unsigned long)s.peak);
+    }
+    fprintf(out, "en uso: %lu bytes\n", (unsigned long)__atomic_load_n(&live, __ATOMIC_RELAXED));
+    if (arena_base == NULL) {
+        fprintf(out, "arena: sin usar\n");
+    } else {
+        fprintf(out, "arena: %lu líneas, máximo %zu bytes por línea\n", (unsigned long)arena_resets,
+                arena_peak);
+    }
+}
+
+void alloc_reset(void) {
+    for (unsigned int i = 0; i < ALLOC_PHASES; i++) {
+        __atomic_store_n(&stats[i].mallocs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats[i].frees, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats[i].bytes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats[i].peak, 0, __ATOMIC_RELAXED);
+    }
+    arena_peak = 0;
+    arena_resets = 0;
+}
@@ -0,0 +1,68 @@
+/* Contabilidad de memoria y arena de parseo.
+ *
+ * alloc.c reemplaza malloc, calloc, realloc y free del programa (glibc
+ * permite reemplazarlas definiéndolas en el ejecutable) y delega en las
+ * funciones internas de glibc. Cada pedido se cuenta en la fase en la que
+ * está el hilo: parseo, expansión, armado (planificación y trazas) o
+ * ejecución.
+ *
+ * Con `set -o arena', lo que se pide mientras se parsea y expande una
+ * línea sale de una arena: un bloque de memoria virtual reservado una vez
+ * donde cada pedido sólo avanza un puntero. free() de esa memoria no hace
+ * nada; alloc_arena_reset() la devuelve entera de una vez, después de
+ * pipeline_destroy().
+ *
+ * Los contadores son del proceso: lo que piden los hijos no aparece.
+ */
+
+#ifndef _ALLOC_H_
+#define _ALLOC_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef enum {
+    ALLOC_OTHER,    // fuera de una línea: lectura, historial, inicialización
+    ALLOC_PARSE,    // parseo de la línea
+    ALLOC_EXPAND,   // expansión de variables, comillas y patrones
+    ALLOC_BUILD,    // planificación y trazas del pipeline ya armado
+    ALLOC_EXECUTE,  // ejecución y destrucción del pipeline
+    ALLOC_PHASES    // cantidad de fases, no es una fase
+} alloc_phase_t;
+
+alloc_phase_t alloc_phase(alloc_phase_t phase);
+/*
+ * Pasa el hilo actual a la fase `phase' y devuelve la anterior, para
+ * restaurarla al terminar.
+ *
+ * REQUIRES: phase < ALLOC_PHASES
+ */
+
+bool alloc_arena(bool on);
+/*
+ * Prende o apaga la arena para el hilo actual y devuelve si estaba
+ * prendida. Si no se puede reservar la arena, los pedidos siguen yendo a
+ * malloc.
+ */
+
+void alloc_arena_reset(void);
+/*
+ * Descarta todo lo que se pidió a la arena desde el último reset. Nada de
+ * esa memoria puede seguir en uso.
+ */
+
+void alloc_print(FILE *out);
+/*
+ * Muestra, por fase, la cantidad de pedidos y de liberaciones, los bytes
+ * pedidos y el máximo de memoria en uso alcanzado; luego el uso de la
+ * arena.
+ *
+ * REQUIRES: out != NULL
+ */
+
+void alloc_reset(void);
+/*
+ * Pone en cero los contadores. La memoria en uso sigue contando.
+ */
+
+#endif
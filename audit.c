@@ -0,0 +1,295 @@
+#define _GNU_SOURCE     /* pthread_atfork(), eventfd() */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#include "audit.h"
+#include "metrics.h"
+#include "vars.h"
+
+#define AUDIT_RING (1 << 20)            // bytes del buffer circular
+#define AUDIT_MAX_TEXT (64 * 1024)      // un pipeline más largo se recorta
+#define AUDIT_INTERVAL_MS 100           // el hilo escribe al menos con esta frecuencia
+#define AUDIT_FULL_WAIT_NS 100000       // con el buffer lleno y `block', cada cuánto se reintenta
+
+struct audit_entry_s {
+    struct timespec when;   // hora (real) en que empezó
+    char *cwd;
+    char *text;
+};
+
+// Encabezado de cada registro en el buffer; le siguen el directorio y el
+// texto, y el largo total se redondea a 8 para que el encabezado siguiente
+// quede alineado
+struct record_s {
+    uint32_t len;
+    uint32_t cwd_len;
+    int32_t status;
+    int32_t nsec;
+    int64_t sec;
+};
+
+static char *ring = NULL;           // NULL: no se registra nada
+static size_t head = 0;             // fin de lo escrito; lo mueve sólo el shell
+static size_t tail = 0;             // fin de lo consumido; lo mueve sólo el hilo
+static uint64_t dropped = 0;        // registros descartados con el buffer lleno
+static bool block_when_full = true;
+static bool stopping = false;
+static bool in_child = false;       // proceso hijo: no hay hilo, se escribe en el momento
+static int audit_fd = -1;
+static int wake_fd = -1;            // eventfd con el que el shell despierta al hilo
+static pid_t shell_pid;
+static pthread_t writer;
+
+static void ring_put(size_t pos, const void *src, size_t n) {
+    size_t off = pos % AUDIT_RING;
+    size_t first = n < AUDIT_RING - off ? n : AUDIT_RING - off;
+    memcpy(ring + off, src, first);
+    memcpy(ring, (const char *)src + first, n - first);
+}
+
+static void ring_get(size_t pos, void *dst, size_t n) {
+    size_t off = pos % AUDIT_RING;
+    size_t first = n < AUDIT_RING - off ? n : AUDIT_RING - off;
+    memcpy(dst, ring + off, first);
+    memcpy((char *)dst + first, ring, n - first);
+}
+
+static void wake(void) {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        // el contador del eventfd ya está lleno: el hilo ya tiene que despertar
+    }
+}
+
+static void reserve(char **buf, size_t *cap, size_t need) {
+    if (need > *cap) {
+        *cap = need > 2 * *cap ? need : 2 * *cap;
+        *buf = realloc(*buf, *cap);
+    }
+}
+
+static size_t put_escaped(char **buf, size_t *cap, size_t len, const char *s, size_t n) {
+    // agrega `s' sin tabs, saltos de línea ni caracteres de control
+    reserve(buf, cap, len + 4 * n + 1);
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '\t' || c == '\n' || c == '\\') {
+            (*buf)[len++] = '\\';
+            (*buf)[len++] = c == '\t' ? 't' : (c == '\n' ? 'n' : '\\');
+        } else if (c < 0x20 || c == 0x7f) {
+            len += (size_t)sprintf(*buf + len, "\\x%02x", c);
+        } else {
+            (*buf)[len++] = (char)c;
+        }
+    }
+    return len;
+}
+
+static size_t put_line(char **buf, size_t *cap, size_t len, const struct record_s *rec, pid_t pid,
+                       const char *cwd, const char *text, size_t text_len) {
+    // agrega al final de `buf' la línea de un registro
+    struct tm tm;
+    time_t sec = (time_t)rec->sec;
+    gmtime_r(&sec, &tm);
+    reserve(buf, cap, len + 80);
+    len += strftime(*buf + len, 32, "%Y-%m-%dT%H:%M:%S", &tm);
+    len += (size_t)sprintf(*buf + len, ".%06dZ\t%d\t%d\t", rec->nsec / 1000, (int)pid, rec->status);
+    len = put_escaped(buf, cap, len, cwd, rec->cwd_len);
+    (*buf)[len++] = '\t';
+    len = put_escaped(buf, cap, len, text, text_len);
+    (*buf)[len++] = '\n';
+    return len;
+}
+
+static void write_all(const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(audit_fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return; // sin lugar en el disco: no hay a quién avisarle sin frenar al shell
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+static void *writer_main(void *arg) {
+    // vacía el buffer en tandas: todo lo que haya, en un solo write()
+    char *batch = NULL;
+    size_t cap = 0;
+    char *payload = malloc(PATH_MAX + AUDIT_MAX_TEXT + 8);
+    uint64_t reported = 0;
+    struct pollfd pfd = {wake_fd, POLLIN, 0};
+    for (;;) {
+        bool stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE); // antes de leer head: no se pierde nada
+        size_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+        size_t t = tail;
+        size_t len = 0;
+        while (t != h) {
+            struct record_s rec;
+            ring_get(t, &rec, sizeof(rec));
+            size_t payload_len = rec.len - sizeof(rec);
+            ring_get(t + sizeof(rec), payload, payload_len);
+            t += rec.len;
+            __atomic_store_n(&tail, t, __ATOMIC_RELEASE); // el lugar ya se puede reusar
+            size_t text_len = strnlen(payload + rec.cwd_len, payload_len - rec.cwd_len); // sin el relleno
+            len = put_line(&batch, &cap, len, &rec, shell_pid, payload, payload + rec.cwd_len, text_len);
+        }
+        uint64_t lost = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+        if (lost != reported) {
+            reserve(&batch, &cap, len + 64);
+            len += (size_t)sprintf(batch + len, "# %llu registros descartados\n",
+                                   (unsigned long long)(lost - reported));
+            reported = lost;
+        }
+        if (len > 0) {
+            write_all(batch, len);
+        }
+        if (stop) {
+            break;
+        }
+        if (poll(&pfd, 1, AUDIT_INTERVAL_MS) > 0) {
+            uint64_t count;
+            if (read(wake_fd, &count, sizeof(count)) < 0) {
+                // otro despertar ya lo vació
+            }
+        }
+    }
+    free(payload);
+    free(batch);
+    return NULL;
+}
+
+static void after_fork(void) {
+    in_child = true;
+}
+
+void audit_init(void) {
+    const char *path = vars_get("MYBASH_AUDIT");
+    if (path == NULL || *path == '\0') {
+        return;
+    }
+    const char *full = vars_get("MYBASH_AUDIT_FULL");
+    if (full != NULL && strcmp(full, "block") != 0 && strcmp(full, "drop") != 0) {
+        fprintf(stderr, "mybash: MYBASH_AUDIT_FULL: '%s' no es block ni drop; se usa block\n", full);
+    }
+    block_when_full = full == NULL || strcmp(full, "drop") != 0;
+    audit_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (audit_fd < 0) {
+        fprintf(stderr, "mybash: %s: %s\n", path, strerror(errno));
+        return;
+    }
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ring = malloc(AUDIT_RING);
+    shell_pid = getpid();
+
+    // el hilo no recibe señales: SIGINT, SIGCHLD, ... siguen siendo del shell
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = wake_fd < 0 ? errno : pthread_create(&writer, NULL, writer_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        fprintf(stderr, "mybash: auditoría: %s\n", strerror(err));
+        free(ring);
+        ring = NULL;
+        close(audit_fd);
+        if (wake_fd >= 0) {
+            close(wake_fd);
+        }
+        return;
+    }
+    pthread_atfork(NULL, NULL, after_fork);
+    atexit(audit_close);
+}
+
+audit_entry audit_begin(pipeline pipe) {
+    assert(pipe != NULL);
+    if (ring == NULL) {
+        return NULL;
+    }
+    audit_entry entry = malloc(sizeof(struct audit_entry_s));
+    clock_gettime(CLOCK_REALTIME, &entry->when);
+    char dir[PATH_MAX];
+    entry->cwd = strdup(getcwd(dir, sizeof(dir)) != NULL ? dir : "?");
+    entry->text = pipeline_to_string(pipe);
+    return entry;
+}
+
+static void push(const struct record_s *rec, const char *cwd, const char *text) {
+    size_t h = head;
+    size_t t = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    while (AUDIT_RING - (h - t) < rec->len) { // lleno
+        if (!block_when_full) {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            metrics_count(METRIC_AUDIT_DROPPED);
+            return;
+        }
+        wake();
+        struct timespec pause = {0, AUDIT_FULL_WAIT_NS};
+        nanosleep(&pause, NULL);
+        t = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    }
+    size_t text_len = rec->len - sizeof(*rec) - rec->cwd_len;
+    char pad[8] = {0};
+    size_t len = strnlen(text, text_len);
+    ring_put(h, rec, sizeof(*rec));
+    ring_put(h + sizeof(*rec), cwd, rec->cwd_len);
+    ring_put(h + sizeof(*rec) + rec->cwd_len, text, len);
+    ring_put(h + sizeof(*rec) + rec->cwd_len + len, pad, text_len - len); // ceros hasta múltiplo de 8
+    __atomic_store_n(&head, h + rec->len, __ATOMIC_RELEASE);
+    if (h - t < AUDIT_RING / 2 && h + rec->len - t >= AUDIT_RING / 2) { // pasó la mitad
+        wake();
+    }
+}
+
+void audit_end(audit_entry entry, int status) {
+    if (entry == NULL) {
+        return;
+    }
+    size_t cwd_len = strlen(entry->cwd);
+    size_t text_len = strlen(entry->text);
+    if (text_len > AUDIT_MAX_TEXT) {
+        text_len = AUDIT_MAX_TEXT;
+    }
+    struct record_s rec = {0, (uint32_t)cwd_len, status, (int32_t)entry->when.tv_nsec, entry->when.tv_sec};
+    if (in_child) { // sin hilo: una línea, un write() (O_APPEND la deja entera)
+        char *line = NULL;
+        size_t cap = 0;
+        size_t len = put_line(&line, &cap, 0, &rec, getpid(), entry->cwd, entry->text, text_len);
+        write_all(line, len);
+        free(line);
+    } else {
+        rec.len = (uint32_t)((sizeof(rec) + cwd_len + text_len + 7) & ~(size_t)7);
+        push(&rec, entry->cwd, entry->text);
+    }
+    free(entry->cwd);
+    free(entry->text);
+    free(entry);
+}
+
+void audit_close(void) {
+    if (ring == NULL || in_child) {
+        return;
+    }
+    __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+    wake();
+    pthread_join(writer, NULL);
+    free(ring);
+    ring = NULL;
+    close(wake_fd);
+    close(audit_fd);
+}
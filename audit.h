@@ -0,0 +1,56 @@
+/* Registro de auditoría: cada pipeline ejecutado, con su hora, directorio
+ * y estado de salida.
+ *
+ * Se activa con la variable MYBASH_AUDIT=ARCHIVO (se agrega al final). Para
+ * no sumar una escritura a cada comando, el shell sólo copia el registro a
+ * un buffer circular en memoria, sin locks (un productor, un consumidor), y
+ * un hilo aparte lo vacía en tandas con un solo write() cada
+ * AUDIT_INTERVAL_MS milisegundos o cuando el buffer pasa la mitad. Cada
+ * línea del archivo es
+ *
+ *   2026-01-02T03:04:05.678901Z <TAB> pid <TAB> estado <TAB> directorio <TAB> pipeline
+ *
+ * con tabs, saltos de línea y caracteres de control escapados (\t, \n,
+ * \xNN). Si el buffer se llena, MYBASH_AUDIT_FULL elige qué hacer: `block'
+ * (por omisión) espera a que el hilo haga lugar, `drop' descarta el
+ * registro y lo cuenta (`stats', y una línea "# N registros descartados"
+ * en el archivo). Al salir del shell (exit o fin de la entrada) se escribe
+ * todo lo pendiente. Un proceso hijo del shell que corre comandos, como
+ * ( ... ) o un coproceso, no tiene el hilo: escribe cada línea en el
+ * momento.
+ */
+
+#ifndef _AUDIT_H_
+#define _AUDIT_H_
+
+#include "command.h"
+
+typedef struct audit_entry_s *audit_entry;
+
+void audit_init(void);
+/*
+ * Abre el archivo de $MYBASH_AUDIT y lanza el hilo escritor. Sin la
+ * variable (o si no se puede abrir, con un mensaje) no registra nada.
+ */
+
+audit_entry audit_begin(pipeline pipe);
+/*
+ * Antes de ejecutar `pipe': toma la hora y el texto del pipeline (la
+ * ejecución puede modificarlo). Devuelve NULL si no se registra nada.
+ *
+ * REQUIRES: pipe != NULL
+ */
+
+void audit_end(audit_entry entry, int status);
+/*
+ * Después de ejecutarlo: encola el registro con el estado `status' y
+ * libera `entry'. No hace nada si `entry' es NULL.
+ */
+
+void audit_close(void);
+/*
+ * Escribe lo pendiente, termina el hilo y cierra el archivo. Se llama sola
+ * al salir del shell.
+ */
+
+#endif
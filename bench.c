@@ -0,0 +1,230 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "bench.h"
+#include "command.h"
+#include "execute.h"
+#include "metrics.h"
+#include "parsing.h"
+#include "plan.h"
+
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_INTERRUPTED 130           // estado de un pipeline cortado con Ctrl-C
+
+struct bench_opts_s {
+    unsigned long runs;                 // 0 si se mide por duración
+    unsigned long duration_ms;
+    unsigned long warmup;
+    bool quiet;
+    bool json;
+    const char *pipeline;               // resto de la línea
+};
+
+// Toma la siguiente palabra de `*s' (separada por blancos) en `word'
+static bool next_word(const char **s, char *word, size_t size) {
+    *s += strspn(*s, " \t");
+    size_t len = strcspn(*s, " \t");
+    if (len == 0 || len >= size) {
+        return false;
+    }
+    memcpy(word, *s, len);
+    word[len] = '\0';
+    *s += len;
+    return true;
+}
+
+static bool parse_count(const char *word, unsigned long *n) {
+    char *end;
+    long value = strtol(word, &end, 10);
+    if (end == word || *end != '\0' || value < 0) {
+        return false;
+    }
+    *n = (unsigned long)value;
+    return true;
+}
+
+static bool parse_options(const char *line, struct bench_opts_s *opts) {
+    *opts = (struct bench_opts_s){.runs = BENCH_DEFAULT_RUNS};
+    const char *s = line + strspn(line, " \t") + strlen("bench");
+    char word[64], arg[64];
+    for (;;) {
+        const char *before = s;
+        if (!next_word(&s, word, sizeof(word)) || word[0] != '-') {
+            s = before; // empieza el pipeline
+            break;
+        }
+        if (!strcmp(word, "--")) {
+            break;
+        } else if (!strcmp(word, "-q")) {
+            opts->quiet = true;
+        } else if (!strcmp(word, "-j")) {
+            opts->json = true;
+        } else if (!strcmp(word, "-n") && next_word(&s, arg, sizeof(arg)) &&
+                   parse_count(arg, &opts->runs) && opts->runs > 0) {
+            opts->duration_ms = 0;
+        } else if (!strcmp(word, "-t") && next_word(&s, arg, sizeof(arg)) &&
+                   parse_duration(arg, &opts->duration_ms)) {
+            opts->runs = 0;
+        } else if (!strcmp(word, "-w") && next_word(&s, arg, sizeof(arg)) &&
+                   parse_count(arg, &opts->warmup)) {
+            // ok
+        } else {
+            return false;
+        }
+    }
+    opts->pipeline = s + strspn(s, " \t");
+    return opts->pipeline[0] != '\0';
+}
+
+static double usec(const struct timeval *tv) {
+    return (double)tv->tv_sec * 1e6 + (double)tv->tv_usec;
+}
+
+// Una corrida: parsea, planifica y ejecuta; guarda el tiempo real en `wall_ns'
+static int run_once(const char *text, uint64_t *wall_ns) {
+    pipeline pipe = parse_pipeline_from_string(text);
+    if (pipe == NULL) {
+        return -1;
+    }
+    plan_pipeline(pipe);
+    uint64_t start = metrics_now();
+    int status = execute_pipeline(pipe);
+    *wall_ns = metrics_now() - start;
+    pipeline_destroy(pipe);
+    return status;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Percentil por rango más cercano de una muestra ordenada, en ms
+static double pct(const uint64_t *sorted, size_t n, unsigned int p) {
+    size_t rank = (n * p + 99) / 100;
+    return (double)sorted[rank > 0 ? rank - 1 : 0] / 1e6;
+}
+
+static void print_json_string(const char *s) {
+    putchar('"');
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\') {
+            printf("\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            printf("\\u%04x", (unsigned char)*s);
+        } else {
+            putchar(*s);
+        }
+    }
+    putchar('"');
+}
+
+static void report(const struct bench_opts_s *opts, uint64_t *samples, size_t n,
+                   double user_us, double sys_us, int status) {
+    qsort(samples, n, sizeof(uint64_t), compare_u64);
+    double total_ms = 0;
+    for (size_t i = 0; i < n; i++) {
+        total_ms += (double)samples[i] / 1e6;
+    }
+    double mean = total_ms / (double)n;
+    double cpu_pct = total_ms > 0 ? (user_us + sys_us) / 1e3 / total_ms * 100 : 0;
+
+    if (opts->json) {
+        printf("{\"command\": ");
+        print_json_string(opts->pipeline);
+        printf(", \"runs\": %zu, \"warmup\": %lu, \"status\": %d, "
+               "\"wall_ms\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+               "\"max\": %.3f, \"mean\": %.3f}, "
+               "\"cpu_ms\": {\"user\": %.3f, \"sys\": %.3f}, \"cpu_percent\": %.1f}\n",
+               n, opts->warmup, status, (double)samples[0] / 1e6, pct(samples, n, 50),
+               pct(samples, n, 90), pct(samples, n, 99), (double)samples[n - 1] / 1e6, mean,
+               user_us / 1e3 / (double)n, sys_us / 1e3 / (double)n, cpu_pct);
+    } else {
+        printf("bench: %zu corridas (%lu previas) de '%s'\n", n, opts->warmup, opts->pipeline);
+        printf("  real  min %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f  promedio %.3f ms\n",
+               (double)samples[0] / 1e6, pct(samples, n, 50), pct(samples, n, 90),
+               pct(samples, n, 99), (double)samples[n - 1] / 1e6, mean);
+        printf("  cpu   user %.3f  sys %.3f ms por corrida (%.0f%%)\n",
+               user_us / 1e3 / (double)n, sys_us / 1e3 / (double)n, cpu_pct);
+    }
+    fflush(stdout);
+}
+
+bool bench_is_line(const char *line) {
+    assert(line != NULL);
+    line += strspn(line, " \t");
+    return !strncmp(line, "bench", 5) && (line[5] == '\0' || line[5] == ' ' || line[5] == '\t');
+}
+
+int bench_run(const char *line) {
+    assert(line != NULL && bench_is_line(line));
+    struct bench_opts_s opts;
+    if (!parse_options(line, &opts)) {
+        fprintf(stderr, "bench: uso: bench [-n VECES | -t DURACIÓN] [-w PREVIAS] [-q] [-j] [--] pipeline\n");
+        return EXIT_FAILURE;
+    }
+
+    // con -q la salida del pipeline va a /dev/null; el reporte, a la salida original
+    int saved_stdout = -1;
+    if (opts.quiet) {
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) {
+            dup2(devnull, STDOUT_FILENO);
+            close(devnull);
+        }
+    }
+
+    int status = EXIT_SUCCESS;
+    uint64_t wall;
+    for (unsigned long i = 0; i < opts.warmup && status != BENCH_INTERRUPTED; i++) {
+        status = run_once(opts.pipeline, &wall);
+        if (status < 0) {
+            break;
+        }
+    }
+
+    size_t n = 0, cap = opts.runs > 0 ? opts.runs : 64;
+    uint64_t *samples = malloc(cap * sizeof(uint64_t));
+    struct rusage before, after;
+    getrusage(RUSAGE_CHILDREN, &before);
+    uint64_t start = metrics_now();
+    while (status >= 0 && status != BENCH_INTERRUPTED) { // Ctrl-C corta el bench
+        if (opts.runs > 0 ? n >= opts.runs
+                          : n > 0 && metrics_now() - start >= opts.duration_ms * 1000000u) {
+            break;
+        }
+        status = run_once(opts.pipeline, &wall);
+        if (status < 0) {
+            break;
+        }
+        if (n == cap) {
+            cap *= 2;
+            samples = realloc(samples, cap * sizeof(uint64_t));
+        }
+        samples[n++] = wall;
+    }
+    getrusage(RUSAGE_CHILDREN, &after);
+
+    if (saved_stdout >= 0) {
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    if (status < 0) {
+        fprintf(stderr, "Error: comando inválido o error de sintaxis.\n");
+        status = 2;
+    } else if (n > 0) {
+        report(&opts, samples, n, usec(&after.ru_utime) - usec(&before.ru_utime),
+               usec(&after.ru_stime) - usec(&before.ru_stime), status);
+    }
+    free(samples);
+    return status;
+}
@@ -0,0 +1,36 @@
+/* Comando interno `bench': mide cuánto tarda un pipeline.
+ *
+ *   bench [-n VECES | -t DURACIÓN] [-w PREVIAS] [-q] [-j] [--] pipeline
+ *
+ * Corre el pipeline VECES veces (10 por defecto) o hasta completar
+ * DURACIÓN, por el mismo camino que una línea normal (parseo, planificación
+ * y execute_pipeline), y muestra el tiempo real mínimo, p50, p90, p99 y
+ * máximo, y el tiempo de CPU de los hijos. Las PREVIAS corridas de
+ * calentamiento no se cuentan. Con -q se descarta la salida estándar del
+ * pipeline y con -j el resultado sale en JSON.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdbool.h>
+
+bool bench_is_line(const char *line);
+/*
+ * Indica si `line' es una invocación de `bench'. A diferencia de los demás
+ * comandos internos, `bench' recibe un pipeline entero (con sus `|'), así
+ * que se reconoce sobre el texto de la línea, antes de parsearla.
+ *
+ * REQUIRES: line != NULL
+ */
+
+int bench_run(const char *line);
+/*
+ * Ejecuta la línea `bench ...' y devuelve su estado: el de la última
+ * corrida, 2 si el pipeline tiene un error de sintaxis o 1 si las opciones
+ * son inválidas.
+ *
+ * REQUIRES: line != NULL && bench_is_line(line)
+ */
+
+#endif
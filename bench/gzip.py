@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Compara las redirecciones comprimidas con gzip y zcat externos.
+
+Genera (una vez) un archivo de texto del tamaño pedido y mide en mybash:
+  compress:   `cat ARCHIVO > salida.gz' con `set -o gzip' contra
+              `cat ARCHIVO | gzip > salida.gz'
+  decompress: `wc -l < entrada.gz' con `set -o gzip' contra
+              `zcat entrada.gz | wc -l'
+Muestra el tiempo y los MB/s (de datos sin comprimir) de cada caso; la
+mejor de -r repeticiones.
+
+Uso: bench/gzip.py [-s TAMAÑO] [-f ARCHIVO] [-r N] [binario]
+  TAMAÑO admite sufijos K, M y G (por omisión 256M).
+"""
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+
+def parse_size(text):
+    units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30}
+    if text[-1].upper() in units:
+        return int(float(text[:-1]) * units[text[-1].upper()])
+    return int(text)
+
+
+def generate(path, size):
+    if os.path.exists(path) and os.path.getsize(path) >= size:
+        return
+    print(f"generando {path} ({size >> 20} MiB)...")
+    block = b"".join(b"%08d 2024-05-%02d GET /api/v1/items/%d 200 %d ms\n" % (i, i % 28 + 1, i * 7919 % 100000, i % 997)
+                     for i in range(10000))
+    with open(path, "wb") as f:
+        written = 0
+        while written < size:
+            f.write(block)
+            written += len(block)
+
+
+def best(mybash, line, repeat):
+    times = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.run([mybash, "-c", line], stdout=subprocess.DEVNULL, check=True)
+        times.append(time.perf_counter() - start)
+    return min(times)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-s", default="256M")
+    ap.add_argument("-f", default=os.path.join(tempfile.gettempdir(), "mybash-gzip.txt"))
+    ap.add_argument("-r", type=int, default=3)
+    ap.add_argument("mybash", nargs="?", default="./mybash")
+    args = ap.parse_args()
+    mybash = os.path.abspath(args.mybash)
+    generate(args.f, parse_size(args.s))
+    size = os.path.getsize(args.f)
+    out = args.f + ".out.gz"
+    cases = [
+        ("compress", "interno", f"set -o gzip; cat {args.f} > {out}"),
+        ("compress", "gzip", f"cat {args.f} | gzip > {out}"),
+        ("decompress", "interno", f"set -o gzip; wc -l < {out}"),
+        ("decompress", "zcat", f"zcat {out} | wc -l"),
+    ]
+    print(f"{args.f}: {size >> 20} MiB")
+    for kind, how, line in cases:
+        elapsed = best(mybash, line, args.r)
+        print(f"  {kind:10s} {how:8s} {elapsed:8.2f} s  {size / elapsed / (1 << 20):8.1f} MB/s")
+    os.unlink(out)
+
+
+if __name__ == "__main__":
+    main()
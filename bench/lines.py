@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Mide `read' y `mapfile' sobre una entrada grande.
+
+Genera (una vez) un archivo de líneas de texto del tamaño pedido y mide
+cuánto tarda mybash en recorrerlo con un ciclo de `read' y en cargarlo con
+`mapfile', leyendo del archivo (en bloques, con lseek al terminar) y de un
+pipe (de a un byte para `read', en bloques para `mapfile'). Muestra el
+tiempo, las líneas por segundo y los MB/s de cada caso.
+
+Uso: bench/lines.py [-s TAMAÑO] [-f ARCHIVO] [-m MODO ...] [binario]
+  TAMAÑO admite sufijos K, M y G (por omisión 2G).
+  MODOS: read-file, read-pipe, mapfile-file, mapfile-pipe (por omisión, todos).
+"""
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+SCRIPTS = {
+    "read": 'while read -r l; do x="$l"; done',
+    "mapfile": "mapfile; n=$#",
+}
+
+
+def parse_size(text):
+    units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30}
+    if text[-1].upper() in units:
+        return int(float(text[:-1]) * units[text[-1].upper()])
+    return int(text)
+
+
+def generate(path, size):
+    if os.path.exists(path) and os.path.getsize(path) >= size:
+        return
+    print(f"generando {path} ({size >> 20} MiB)...")
+    block = b"".join(b"%08d linea de prueba para el benchmark de read y mapfile %s\n" % (i, b"x" * (i % 40))
+                     for i in range(10000))
+    with open(path, "wb") as f:
+        written = 0
+        while written < size:
+            f.write(block)
+            written += len(block)
+
+
+def count_lines(path):
+    with open(path, "rb") as f:
+        return sum(chunk.count(b"\n") for chunk in iter(lambda: f.read(1 << 20), b""))
+
+
+def run(mybash, mode, path):
+    builtin, source = mode.split("-")
+    script = SCRIPTS[builtin]
+    start = time.perf_counter()
+    if source == "file":
+        with open(path, "rb") as f:
+            subprocess.run([mybash, "-c", script], stdin=f, check=True)
+    else:
+        cat = subprocess.Popen(["cat", path], stdout=subprocess.PIPE)
+        subprocess.run([mybash, "-c", script], stdin=cat.stdout, check=True)
+        cat.stdout.close()
+        cat.wait()
+    return time.perf_counter() - start
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-s", default="2G")
+    ap.add_argument("-f", default=os.path.join(tempfile.gettempdir(), "mybash-lines.txt"))
+    ap.add_argument("-m", action="append", choices=["read-file", "read-pipe", "mapfile-file", "mapfile-pipe"])
+    ap.add_argument("mybash", nargs="?", default="./mybash")
+    args = ap.parse_args()
+    mybash = os.path.abspath(args.mybash)
+    generate(args.f, parse_size(args.s))
+    size = os.path.getsize(args.f)
+    nlines = count_lines(args.f)
+    print(f"{args.f}: {size >> 20} MiB, {nlines} líneas")
+    for mode in args.m or ["read-file", "read-pipe", "mapfile-file", "mapfile-pipe"]:
+        elapsed = run(mybash, mode, args.f)
+        print(f"  {mode:13s} {elapsed:8.2f} s  {nlines / elapsed / 1e6:7.2f} M líneas/s"
+              f"  {size / elapsed / (1 << 20):8.1f} MB/s")
+
+
+if __name__ == "__main__":
+    main()
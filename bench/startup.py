@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Mide cuánto tarda en arrancar mybash.
+
+Para cada binario mide dos cosas: desde el exec hasta que aparece el primer
+prompt, y `mybash -c true' de punta a punta (exec, ejecutar /bin/true y
+terminar). Muestra la mediana y el percentil 90 de cada una, así se pueden
+comparar varios binarios, por ejemplo uno dinámico y uno de `make STATIC=1'.
+
+Uso: bench/startup.py [-n N] [binario ...]
+"""
+import argparse
+import os
+import time
+
+PROMPT = b"mybash> "
+
+
+def spawn(argv, stdin, stdout):
+    actions = [(os.POSIX_SPAWN_DUP2, stdin, 0), (os.POSIX_SPAWN_DUP2, stdout, 1)]
+    return os.posix_spawn(argv[0], argv, os.environ, file_actions=actions)
+
+
+def to_prompt(mybash):
+    in_r, in_w = os.pipe()
+    out_r, out_w = os.pipe()
+    start = time.perf_counter()
+    pid = spawn([mybash], in_r, out_w)
+    os.close(in_r)
+    os.close(out_w)
+    buf = b""
+    while not buf.endswith(PROMPT):
+        chunk = os.read(out_r, 4096)
+        if not chunk:
+            raise SystemExit(f"{mybash} terminó sin mostrar el prompt")
+        buf += chunk
+    elapsed = time.perf_counter() - start
+    os.close(in_w)  # EOF: el shell termina
+    os.close(out_r)
+    os.waitpid(pid, 0)
+    return elapsed
+
+
+def run_true(mybash):
+    devnull = os.open(os.devnull, os.O_RDWR)
+    start = time.perf_counter()
+    pid = spawn([mybash, "-c", "true"], devnull, devnull)
+    _, status = os.waitpid(pid, 0)
+    elapsed = time.perf_counter() - start
+    os.close(devnull)
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise SystemExit(f"{mybash} -c true terminó con error")
+    return elapsed
+
+
+def percentiles(fn, mybash, n):
+    for _ in range(n // 10):  # calentamiento: caché de páginas del binario
+        fn(mybash)
+    samples = sorted(fn(mybash) for _ in range(n))
+    return samples[len(samples) // 2] * 1e6, samples[len(samples) * 9 // 10] * 1e6
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-n", type=int, default=500)
+    ap.add_argument("mybash", nargs="*", default=["./mybash"])
+    args = ap.parse_args()
+    for mybash in args.mybash:
+        mybash = os.path.abspath(mybash)
+        p50, p90 = percentiles(to_prompt, mybash, args.n)
+        print(f"{mybash}\n  hasta el prompt  p50 {p50:6.0f} us   p90 {p90:6.0f} us")
+        p50, p90 = percentiles(run_true, mybash, args.n)
+        print(f"  -c true          p50 {p50:6.0f} us   p90 {p90:6.0f} us")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Compara el lanzamiento de comandos con fork directo y con el pool de
+zygotes (`set -o zygote').
+
+Maneja un mybash como lo haría una sesión interactiva: manda una línea,
+espera el siguiente prompt y deja una pausa antes de la próxima, tiempo en
+el que el pool se repone. Muestra la mediana y el percentil 90 del tiempo
+entre mandar la línea y recibir el prompt.
+
+Uso: bench/zygote.py [-n N] [--pause SEG] [--mybash CAMINO] [comando]
+"""
+import argparse
+import os
+import subprocess
+import time
+
+PROMPT = b"mybash> "
+
+
+def wait_prompt(out):
+    buf = b""
+    while not buf.endswith(PROMPT):
+        chunk = os.read(out, 4096)
+        if not chunk:
+            raise SystemExit("mybash terminó antes de tiempo")
+        buf += chunk
+
+
+def run(mybash, setting, command, n, pause):
+    p = subprocess.Popen([mybash], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                         bufsize=0)
+    out = p.stdout.fileno()
+    wait_prompt(out)
+    p.stdin.write(setting.encode() + b"\n")
+    wait_prompt(out)
+    samples = []
+    for _ in range(n):
+        time.sleep(pause)
+        start = time.perf_counter()
+        p.stdin.write(command.encode() + b"\n")
+        wait_prompt(out)
+        samples.append(time.perf_counter() - start)
+    p.stdin.close()
+    p.wait()
+    samples.sort()
+    return samples[len(samples) // 2] * 1e6, samples[len(samples) * 9 // 10] * 1e6
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-n", type=int, default=500)
+    ap.add_argument("--pause", type=float, default=0.003)
+    ap.add_argument("--mybash", default="./mybash")
+    ap.add_argument("command", nargs="?", default="/bin/true")
+    args = ap.parse_args()
+    for name, setting in (("fork directo", "set +o zygote"), ("zygotes", "set -o zygote")):
+        p50, p90 = run(args.mybash, setting, args.command, args.n, args.pause)
+        print(f"{name:13} p50 {p50:6.0f} us   p90 {p90:6.0f} us")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,81 +1,580 @@
-#include <assert.h>
-#include <errno.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include "tests/syscall_mock.h"
-#include "builtin.h"
-#include "command.h"
-#include "strextra.h"
-
-// Lista de comandos internos reconocidos por el programa
-static const char* builtin_cmds[] = {"cd" , "help", "exit"};
-
-// Cantidad total de comandos internos
-static const unsigned int builtin_size = 3;
-
-// Verifica si el comando recibido en cmd corresponde a un comando interno
-bool builtin_is_internal(scommand cmd) {
-    assert(cmd != NULL); 
-    
-    // Recorre la lista de comandos internos
-    for (unsigned int i = 0; i < builtin_size; i++) {
-        // Compara el primer elemento de cmd con cada comando interno
-        if (!strcmp(scommand_front(cmd), builtin_cmds[i])) {
-            return true;
-        }
-    }
-    
-    return false; // Si no coincide con ninguno, no es un comando interno
-}
-
-
-// Verifica si el pipeline contiene un único comando y si dicho comando es interno
-bool builtin_alone(pipeline p) {
-    assert(p != NULL);
-    
-    // Devuelve true solo si:
-    // 1) El pipeline tiene exactamente un comando
-    // 2) Ese comando pertenece a la lista de comandos internos
-    return (pipeline_length(p) == 1) && builtin_is_internal(pipeline_front(p));
-}
-
-
-// Ejecuta un comando interno (cd, help o exit)
-void builtin_run(scommand cmd) {
-    assert(builtin_is_internal(cmd));
-    
-    // Caso: comando "cd"
-    if (!strcmp(scommand_front(cmd), builtin_cmds[0])) {
-        scommand_pop_front(cmd); // Quita "cd" y deja solo el posible argumento
-        
-        // Si no se especifica directorio, se redirige al home del usuario
-        if (scommand_length(cmd) == 0) {
-            char* user_name = getenv("USER");           // Obtiene el nombre del usuario
-            char* home_dir = strmerge("/home/", user_name); // Construye la ruta /home/usuario
-            scommand_push_back(cmd, home_dir);          // Inserta la ruta como argumento
-        }
-
-        // Intenta cambiar al directorio indicado
-        int cd = chdir(scommand_front(cmd));  
-        
-        // Si falla, muestra un mensaje de error en stderr
-        if (cd == -1) { 
-            fprintf(stderr, "cd: cannot access '%s': %s\n",
-                scommand_front(cmd), strerror(errno));
-        }
-    
-    // Caso: comando "help"
-    } else if (!strcmp(scommand_front(cmd), builtin_cmds[1])) {
-        printf("Bash created by Facundo Mauvecin, Patricio Rivadeneira and Isabelle Costa.\n"
-               "In this bash, you can use the following commands:\n"
-               "cd <pathname>   - To change directories\n"
-               "exit            - To exit bash\n"
-               "help            - To see how the commands work\n");
-    
-    // Caso: comando "exit"
-    } else {
-        exit(EXIT_SUCCESS); // Finaliza el programa con éxito
-    } 
-}
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tests/syscall_mock.h"
+#include "builtin.h"
+#include "command.h"
+#include "strextra.h"
+#include "options.h"
+#include "vars.h"
+#include "history.h"
+#include "metrics.h"
+#include "alloc.h"
+#include "lines.h"
+#include "redir.h"
+#include "coproc.h"
+
+// Lista de comandos internos reconocidos por el programa
+static const char* builtin_cmds[] = {"cd" , "help", "exit", "set", "export", "unset", "history", "stats",
+                                     "read", "mapfile", "exec", "coproc"};
+
+// Cantidad total de comandos internos
+static const unsigned int builtin_size = sizeof(builtin_cmds) / sizeof(builtin_cmds[0]);
+
+// Entradas que muestra "history" sin argumentos
+#define HISTORY_DEFAULT_LAST 500
+
+// Indica si todas las palabras del comando son asignaciones NOMBRE=valor
+static bool builtin_only_assignments(scommand cmd) {
+    for (unsigned int i = 0; i < scommand_length(cmd); i++) {
+        if (!vars_is_assignment(scommand_nth(cmd, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Define la variable de una palabra NOMBRE=valor
+static void builtin_assign(char *word) {
+    char *eq = strchr(word, '=');
+    *eq = '\0';
+    vars_set(word, eq + 1);
+    *eq = '=';
+}
+
+// Verifica si el comando recibido en cmd corresponde a un comando interno
+bool builtin_is_internal(scommand cmd) {
+    assert(cmd != NULL); 
+    
+    // Recorre la lista de comandos internos
+    for (unsigned int i = 0; i < builtin_size; i++) {
+        // Compara el primer elemento de cmd con cada comando interno
+        if (!strcmp(scommand_front(cmd), builtin_cmds[i])) {
+            return true;
+        }
+    }
+    
+    // Una línea con sólo asignaciones (A=1 B=2) también se resuelve en el shell
+    return builtin_only_assignments(cmd); // Si no, no es un comando interno
+}
+
+
+// Verifica si el pipeline contiene un único comando y si dicho comando es interno
+bool builtin_alone(pipeline p) {
+    assert(p != NULL);
+    
+    // Devuelve true solo si:
+    // 1) El pipeline tiene exactamente un comando
+    // 2) Ese comando pertenece a la lista de comandos internos
+    return (pipeline_length(p) == 1) && builtin_is_internal(pipeline_front(p));
+}
+
+
+// Activa/desactiva opciones: set [-x|+x] [-o nombre|+o nombre]; sin argumentos las lista
+static int builtin_set(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "set"
+
+    if (scommand_is_empty(cmd)) {
+        for (unsigned int i = 0; i < OPT_COUNT; i++) {
+            printf("%-10s %s\n", option_name((shell_option_t)i),
+                   option_get((shell_option_t)i) ? "on" : "off");
+        }
+        return EXIT_SUCCESS;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    while (!scommand_is_empty(cmd)) {
+        char *flag = scommand_front(cmd);
+        bool value = flag[0] == '-';
+        if ((flag[0] == '-' || flag[0] == '+') && !strcmp(flag + 1, "x")) {
+            option_set(OPT_TRACE, value);
+        } else if ((flag[0] == '-' || flag[0] == '+') && !strcmp(flag + 1, "o") &&
+                   scommand_length(cmd) > 1) {
+            scommand_pop_front(cmd);
+            shell_option_t opt;
+            if (option_lookup(scommand_front(cmd), &opt)) {
+                option_set(opt, value);
+            } else {
+                fprintf(stderr, "set: %s: opción inválida\n", scommand_front(cmd));
+                status = EXIT_FAILURE;
+            }
+        } else {
+            fprintf(stderr, "set: %s: opción inválida\n", flag);
+            return EXIT_FAILURE;
+        }
+        scommand_pop_front(cmd);
+    }
+    return status;
+}
+
+// export [NOMBRE[=valor] ...]; sin argumentos lista las variables exportadas
+static int builtin_export(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "export"
+
+    if (scommand_is_empty(cmd)) {
+        vars_print_exported();
+        return EXIT_SUCCESS;
+    }
+    int status = EXIT_SUCCESS;
+    for (; !scommand_is_empty(cmd); scommand_pop_front(cmd)) {
+        char *arg = scommand_front(cmd);
+        char *eq = strchr(arg, '=');
+        size_t len = eq != NULL ? (size_t)(eq - arg) : strlen(arg);
+        if (!vars_valid_name(arg, len)) {
+            fprintf(stderr, "export: '%s': no es un identificador válido\n", arg);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        if (eq != NULL) {
+            builtin_assign(arg);
+            *eq = '\0';
+            vars_export(arg);
+            *eq = '=';
+        } else {
+            vars_export(arg);
+        }
+    }
+    return status;
+}
+
+// unset NOMBRE ...
+static void builtin_unset(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "unset"
+    for (; !scommand_is_empty(cmd); scommand_pop_front(cmd)) {
+        vars_unset(scommand_front(cmd));
+    }
+}
+
+// history [N] | history -p prefijo | history -s texto
+static int builtin_history(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "history"
+
+    if (scommand_is_empty(cmd)) {
+        history_print_last(HISTORY_DEFAULT_LAST);
+    } else if (scommand_length(cmd) == 2 && (!strcmp(scommand_front(cmd), "-p") ||
+                                             !strcmp(scommand_front(cmd), "-s"))) {
+        bool prefix = !strcmp(scommand_front(cmd), "-p");
+        history_print_matches(scommand_nth(cmd, 1), prefix);
+    } else {
+        char *end;
+        long n = strtol(scommand_front(cmd), &end, 10);
+        if (*end != '\0' || n < 0) {
+            fprintf(stderr, "history: uso: history [N] | -p prefijo | -s texto\n");
+            return EXIT_FAILURE;
+        }
+        history_print_last((size_t)n);
+    }
+    return EXIT_SUCCESS;
+}
+
+// stats | stats -p (formato Prometheus) | stats alloc (memoria por fase) | stats reset
+static int builtin_stats(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "stats"
+
+    if (scommand_is_empty(cmd)) {
+        metrics_print(stdout);
+    } else if (scommand_length(cmd) == 1 && !strcmp(scommand_front(cmd), "-p")) {
+        metrics_print_prometheus(stdout);
+    } else if (scommand_length(cmd) == 1 && !strcmp(scommand_front(cmd), "alloc")) {
+        alloc_print(stdout);
+    } else if (scommand_length(cmd) == 1 && !strcmp(scommand_front(cmd), "reset")) {
+        metrics_reset();
+        alloc_reset();
+    } else {
+        fprintf(stderr, "stats: uso: stats [-p | alloc | reset]\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Descriptor del que leen read y mapfile: `fd' (o el que guardó exec para
+// él), o el archivo de `< archivo' (que hay que cerrar después, *opened).
+// -1 si no se pudo abrir
+static int builtin_input(scommand cmd, const char *name, int fd, bool *opened) {
+    char *file = scommand_get_redir_in(cmd);
+    *opened = file != NULL;
+    if (file == NULL) {
+        return redir_fd(fd);
+    }
+    fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s: %s\n", name, file, strerror(errno));
+    }
+    return fd;
+}
+
+// Lee el número de una opción (-u 3, -n 10); false si no es un número >= 0
+static bool builtin_number(const char *arg, long *n) {
+    char *end;
+    errno = 0;
+    *n = strtol(arg, &end, 10);
+    return *arg != '\0' && *end == '\0' && errno == 0 && *n >= 0;
+}
+
+// Toma un campo de la línea de read. Sin `raw', '\\' hace literal al carácter
+// siguiente. Con `rest' el campo llega hasta el final (el de la última
+// variable) y sin `trim' se dejan los blancos de los extremos (REPLY)
+static char *read_field(const char **pos, bool rest, bool trim, bool raw) {
+    const char *s = trim ? *pos + strspn(*pos, " \t") : *pos;
+    char *field = malloc(strlen(s) + 1);
+    size_t len = 0;
+    size_t keep = 0; // largo sin los blancos finales sin escapar
+    for (; *s != '\0'; s++) {
+        if (!raw && *s == '\\' && s[1] != '\0') {
+            field[len++] = *++s;
+            keep = len;
+        } else if (*s == ' ' || *s == '\t') {
+            if (!rest) {
+                break;
+            }
+            field[len++] = *s;
+        } else {
+            field[len++] = *s;
+            keep = len;
+        }
+    }
+    field[trim ? keep : len] = '\0';
+    *pos = s;
+    return field;
+}
+
+// read [-r] [-u FD] [NOMBRE ...]: lee una línea y la reparte en las variables
+// por los blancos; la última se lleva el resto. Sin nombres, va a REPLY
+static int builtin_read(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "read"
+
+    bool raw = false;
+    long fd = STDIN_FILENO;
+    for (; !scommand_is_empty(cmd) && scommand_front(cmd)[0] == '-'; scommand_pop_front(cmd)) {
+        if (!strcmp(scommand_front(cmd), "-r")) {
+            raw = true;
+        } else if (!strcmp(scommand_front(cmd), "-u") && scommand_length(cmd) > 1) {
+            scommand_pop_front(cmd);
+            if (!builtin_number(scommand_front(cmd), &fd) || fd > INT_MAX) {
+                fprintf(stderr, "read: %s: descriptor inválido\n", scommand_front(cmd));
+                return EXIT_FAILURE;
+            }
+        } else {
+            fprintf(stderr, "read: uso: read [-r] [-u fd] [nombre ...]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    for (unsigned int i = 0; i < scommand_length(cmd); i++) {
+        if (!vars_valid_name(scommand_nth(cmd, i), strlen(scommand_nth(cmd, i)))) {
+            fprintf(stderr, "read: '%s': no es un identificador válido\n", scommand_nth(cmd, i));
+            return EXIT_FAILURE;
+        }
+    }
+    bool opened;
+    int in = builtin_input(cmd, "read", (int)fd, &opened);
+    if (in < 0) {
+        return EXIT_FAILURE;
+    }
+
+    // sin -r, una '\\' al final de la línea la continúa en la siguiente
+    lines reader = lines_open(in, false);
+    char *text = strdup("");
+    size_t text_len = 0;
+    bool complete = false;
+    const char *part;
+    size_t len;
+    while ((part = lines_next(reader, &len, &complete)) != NULL) {
+        text = realloc(text, text_len + len + 1);
+        memcpy(text + text_len, part, len + 1);
+        text_len += len;
+        size_t slashes = 0;
+        while (slashes < text_len && text[text_len - 1 - slashes] == '\\') {
+            slashes++;
+        }
+        if (raw || !complete || slashes % 2 == 0) {
+            break;
+        }
+        text[--text_len] = '\0';
+    }
+    lines_close(reader);
+    if (opened) {
+        close(in);
+    }
+
+    const char *pos = text;
+    if (scommand_is_empty(cmd)) {
+        char *value = read_field(&pos, true, false, raw);
+        vars_set("REPLY", value);
+        free(value);
+    }
+    for (unsigned int i = 0; i < scommand_length(cmd); i++) {
+        char *value = read_field(&pos, i + 1 == scommand_length(cmd), true, raw);
+        vars_set(scommand_nth(cmd, i), value);
+        free(value);
+    }
+    free(text);
+    return complete ? EXIT_SUCCESS : EXIT_FAILURE; // al llegar al final, falla (y corta el while)
+}
+
+// mapfile [-t] [-n N] [-s N] [-u FD]: las líneas de la entrada pasan a ser
+// los parámetros $1, $2, ...; con -s se saltean las primeras N y con -n se
+// leen a lo sumo N. Sin -n lee todo en bloques, también de un pipe
+static int builtin_mapfile(scommand cmd) {
+    scommand_pop_front(cmd); // Quita "mapfile"
+
+    long count = 0;
+    long skip = 0;
+    long fd = STDIN_FILENO;
+    for (; !scommand_is_empty(cmd); scommand_pop_front(cmd)) {
+        const char *flag = scommand_front(cmd);
+        long *value = NULL;
+        if (!strcmp(flag, "-t")) {
+            continue; // las líneas nunca llevan el '\n'
+        } else if (!strcmp(flag, "-n")) {
+            value = &count;
+        } else if (!strcmp(flag, "-s")) {
+            value = &skip;
+        } else if (!strcmp(flag, "-u")) {
+            value = &fd;
+        }
+        if (value == NULL || scommand_length(cmd) < 2) {
+            fprintf(stderr, "mapfile: uso: mapfile [-t] [-n cantidad] [-s saltear] [-u fd]\n");
+            return EXIT_FAILURE;
+        }
+        scommand_pop_front(cmd);
+        if (!builtin_number(scommand_front(cmd), value) || (value == &fd && fd > INT_MAX)) {
+            fprintf(stderr, "mapfile: %s: número inválido\n", scommand_front(cmd));
+            return EXIT_FAILURE;
+        }
+    }
+    bool opened;
+    int in = builtin_input(cmd, "mapfile", (int)fd, &opened);
+    if (in < 0) {
+        return EXIT_FAILURE;
+    }
+
+    lines reader = lines_open(in, count == 0);
+    char **args = malloc(16 * sizeof(char *));
+    size_t cap = 16;
+    size_t n = 0;
+    const char *line;
+    size_t len;
+    bool complete;
+    while ((count == 0 || (long)n < count) && (line = lines_next(reader, &len, &complete)) != NULL) {
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        if (n + 1 == cap) {
+            cap *= 2;
+            args = realloc(args, cap * sizeof(char *));
+        }
+        args[n++] = strndup(line, len);
+    }
+    lines_close(reader);
+    if (opened) {
+        close(in);
+    }
+    args[n] = NULL;
+    vars_set_args(args);
+    return EXIT_SUCCESS;
+}
+
+// Aparta el descriptor `fd' del shell en saved[fd] (-1 si estaba cerrado),
+// la primera vez que una redirección lo toca
+static void builtin_save(int fd, int saved[REDIR_FDS]) {
+    if (saved[fd] == REDIR_UNTOUCHED) {
+        saved[fd] = fcntl(fd, F_DUPFD_CLOEXEC, REDIR_FDS);
+    }
+}
+
+// Abre `file' como el descriptor `fd' del shell
+static bool builtin_open_as(const char *file, int flags, int fd) {
+    int opened = open(file, flags | O_CLOEXEC, 0666);
+    if (opened < 0) {
+        fprintf(stderr, "Error al abrir archivo '%s': %s\n", file, strerror(errno));
+        return false;
+    }
+    bool ok = dup2(opened, fd) >= 0;
+    close(opened);
+    return ok;
+}
+
+// Un comando interno que corre solo lo hace en el shell: sus redirecciones
+// (< archivo, > archivo, 2>err, >>log, 2>&1) se aplican a los descriptores
+// del shell mientras corre, y lo que había queda en `saved' para
+// builtin_restore(). exec y coproc usan las redirecciones de otra forma
+static bool builtin_redirect(scommand cmd, int saved[REDIR_FDS]) {
+    for (int fd = 0; fd < REDIR_FDS; fd++) {
+        saved[fd] = REDIR_UNTOUCHED;
+    }
+    if (!strcmp(scommand_front(cmd), "exec") || !strcmp(scommand_front(cmd), "coproc")) {
+        return true; // sus redirecciones son parte del comando
+    }
+    char *in = scommand_get_redir_in(cmd);
+    char *out = scommand_get_redir_out(cmd);
+    if (in == NULL && out == NULL && scommand_fdredir_count(cmd) == 0) {
+        return true;
+    }
+    fflush(stdout); // lo pendiente va a la salida de antes
+    fflush(stderr);
+    if (in != NULL) {
+        builtin_save(STDIN_FILENO, saved);
+    }
+    if (out != NULL) {
+        builtin_save(STDOUT_FILENO, saved);
+    }
+    for (unsigned int n = 0; n < scommand_fdredir_count(cmd); n++) {
+        int fd;
+        char *target;
+        scommand_get_fdredir(cmd, n, &fd, &target);
+        builtin_save(fd, saved);
+    }
+    return (in == NULL || builtin_open_as(in, O_RDONLY, STDIN_FILENO)) &&
+           (out == NULL || builtin_open_as(out, O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO)) &&
+           redir_apply(cmd);
+}
+
+// Devuelve a los descriptores del shell lo que apartó builtin_redirect()
+static void builtin_restore(int saved[REDIR_FDS]) {
+    fflush(stdout);
+    fflush(stderr);
+    for (int fd = 0; fd < REDIR_FDS; fd++) {
+        if (saved[fd] == REDIR_UNTOUCHED) {
+            continue;
+        }
+        if (saved[fd] >= 0) {
+            dup2(saved[fd], fd);
+            close(saved[fd]);
+        } else {
+            close(fd);
+        }
+    }
+}
+
+// Ejecuta un comando interno (cd, help, exit, set, export, unset, history, stats, read, mapfile, exec, coproc
+// o asignaciones) con los descriptores como estén
+static int builtin_dispatch(scommand cmd) {
+    int status = EXIT_SUCCESS;
+    
+    // Caso: asignaciones NOMBRE=valor
+    if (builtin_only_assignments(cmd)) {
+        for (unsigned int i = 0; i < scommand_length(cmd); i++) {
+            builtin_assign(scommand_nth(cmd, i));
+        }
+
+    // Caso: comando "cd"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[0])) {
+        scommand_pop_front(cmd); // Quita "cd" y deja solo el posible argumento
+        
+        // Si no se especifica directorio, se redirige al home del usuario
+        if (scommand_length(cmd) == 0) {
+            char* user_name = getenv("USER");           // Obtiene el nombre del usuario
+            char* home_dir = strmerge("/home/", user_name); // Construye la ruta /home/usuario
+            scommand_push_back(cmd, home_dir);          // Inserta la ruta como argumento
+        }
+
+        // Intenta cambiar al directorio indicado
+        int cd = chdir(scommand_front(cmd));  
+        
+        // Si falla, muestra un mensaje de error en stderr
+        if (cd == -1) { 
+            fprintf(stderr, "cd: cannot access '%s': %s\n",
+                scommand_front(cmd), strerror(errno));
+            status = EXIT_FAILURE;
+        }
+    
+    // Caso: comando "help"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[1])) {
+        printf("Bash created by Facundo Mauvecin, Patricio Rivadeneira and Isabelle Costa.\n"
+               "In this bash, you can use the following commands:\n"
+               "cd <pathname>   - To change directories\n"
+               "exit [N]        - To exit bash (with status N)\n"
+               "help            - To see how the commands work\n"
+               "set [-+]o <opt> - To enable/disable a shell option (set -x traces)\n"
+               "export NAME=val - To set a variable and pass it to commands\n"
+               "unset NAME      - To remove a variable\n"
+               "history [N]     - To list the last commands (-p prefix, -s substring search)\n"
+               "stats [-p]      - To see the shell's own metrics (-p Prometheus format, alloc memory, reset)\n"
+               "bench -n N cmd  - To time a pipeline N times (-t 5s, -w warmup, -q, -j JSON)\n"
+               "timeout 5s cmd  - To stop a pipeline that runs longer (ms, s, m, h)\n"
+               "cpus 0-3 cmd    - To run a pipeline on some CPUs (also nice -n N, ionice be:7, cgroup NAME)\n"
+               "a; b            - To run several commands in a row\n"
+               "if/while/until  - if c; then ...; else ...; fi, while c; do ...; done\n"
+               "for x in w ...  - for x in a b c; do ...; done (break/continue [N])\n"
+               "f() { ...; }    - To define a function ($1 ... $#, $@, return [N])\n"
+               "{ a; b; } > f   - Group run in the shell; ( a; b ) runs in a subshell\n"
+               "read [-r] a b   - To read a line into variables (-u fd, < file)\n"
+               "mapfile [-n N]  - To read all lines into $1, $2, ... (-s skip, -u fd, < file)\n"
+               "exec 3>file     - To keep fd 3 open for later commands (3>>, 3<, 3>&1, 3>&-)\n"
+               "cmd 2>&1 >>log  - To redirect other fds (N>file, N>>file, N<file, N>&M)\n"
+               "coproc NAME cmd - To start cmd once with pipes ($NAME_1 writes to it, $NAME_0 reads)\n");
+    
+    // Caso: comando "set"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[3])) {
+        status = builtin_set(cmd);
+
+    // Caso: comando "export"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[4])) {
+        status = builtin_export(cmd);
+
+    // Caso: comando "unset"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[5])) {
+        builtin_unset(cmd);
+
+    // Caso: comando "history"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[6])) {
+        status = builtin_history(cmd);
+
+    // Caso: comando "stats"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[7])) {
+        status = builtin_stats(cmd);
+
+    // Caso: comando "read"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[8])) {
+        status = builtin_read(cmd);
+
+    // Caso: comando "mapfile"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[9])) {
+        status = builtin_mapfile(cmd);
+
+    // Caso: comando "exec"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[10])) {
+        status = redir_exec(cmd);
+
+    // Caso: comando "coproc"
+    } else if (!strcmp(scommand_front(cmd), builtin_cmds[11])) {
+        status = coproc_start(cmd);
+
+    // Caso: comando "exit"
+    } else {
+        scommand_pop_front(cmd); // Quita "exit"
+        if (scommand_is_empty(cmd)) {
+            exit(vars_get_status()); // sin argumento, con el estado del último comando
+        }
+        char *end;
+        long code = strtol(scommand_front(cmd), &end, 10);
+        if (*scommand_front(cmd) == '\0' || *end != '\0') {
+            fprintf(stderr, "exit: %s: se necesita un argumento numérico\n", scommand_front(cmd));
+            exit(2);
+        }
+        exit((int)(code & 0xff)); // Finaliza el programa
+    } 
+    return status;
+}
+
+int builtin_run(scommand cmd) {
+    assert(builtin_is_internal(cmd));
+    int saved[REDIR_FDS];
+    int status = builtin_redirect(cmd, saved) ? builtin_dispatch(cmd) : EXIT_FAILURE;
+    builtin_restore(saved);
+    return status;
+}
+
+void builtin_exec(scommand cmd) {
+    assert(builtin_is_internal(cmd));
+    int status = builtin_dispatch(cmd);
+    fflush(stdout);
+    _exit(status);
+}
@@ -29,9 +29,21 @@ bool builtin_alone(pipeline p);
  *
  */
 
-void builtin_run(scommand cmd);
+int builtin_run(scommand cmd);
 /*
- * Ejecuta un comando interno
+ * Ejecuta un comando interno en el shell y devuelve su estado de salida (0
+ * si tuvo éxito). Sus redirecciones (< y >, 2>err, 2>&1, ...) valen
+ * mientras corre; las de exec y coproc son parte del comando.
+ *
+ * REQUIRES: {builtin_is_internal(cmd)}
+ *
+ */
+
+void builtin_exec(scommand cmd);
+/*
+ * En el proceso hijo de un pipeline (`stats | head'), con la entrada, la
+ * salida y las redirecciones ya puestas: ejecuta el comando interno y
+ * termina el proceso con su estado.
  *
  * REQUIRES: {builtin_is_internal(cmd)}
  *
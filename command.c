@@ -1,23 +1,83 @@
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
-#include <glib.h>
+#include <string.h>
 
 #include "command.h"
 #include "strextra.h"
 
+struct list_s {         // arreglo de punteros que crece al agregar al final
+    void **items;
+    unsigned int len;
+    unsigned int cap;
+};
+
+static void list_push(struct list_s *l, void *item) {
+    if (l->len == l->cap) {
+        l->cap = l->cap == 0 ? 4 : 2 * l->cap;
+        l->items = realloc(l->items, l->cap * sizeof(void *));
+    }
+    l->items[l->len++] = item;
+}
+
+static void *list_take(struct list_s *l, unsigned int n) { // quita y devuelve el n-ésimo
+    void *item = l->items[n];
+    memmove(l->items + n, l->items + n + 1, (l->len - n - 1) * sizeof(void *));
+    l->len--;
+    return item;
+}
+
+static void list_free(struct list_s *l, void (*destroy)(void *)) { // libera también cada elemento
+    for (unsigned int i = 0; i < l->len; i++) {
+        destroy(l->items[i]);
+    }
+    free(l->items);
+    l->items = NULL;
+    l->len = l->cap = 0;
+}
+
+struct procsub_s {
+    pipeline inner;     // pipeline que corre concurrentemente
+    bool output;        // true para >(...), false para <(...)
+    unsigned int slot;  // índice en args del argumento que reemplaza (UINT_MAX: ninguno)
+};
+
+struct fdredir_s {
+    int fd;             // el descriptor que se redirige
+    fdredir_t kind;
+    char *target;       // archivo, o descriptor (o "-") de N>&M
+};
+
 struct scommand_s {
-    GQueue *args;
+    struct list_s args;
     char *in;
     char *out;
+    struct list_s subs; // sustituciones de procesos, en orden de aparición
+    struct list_s fds;  // redirecciones de descriptores, en orden de aparición
 };
 
+static void fdredir_free(void *data) {
+    struct fdredir_s *redir = data;
+    free(redir->target);
+    free(redir);
+}
+
+static void procsub_free(void *data) {
+    struct procsub_s *sub = data;
+    pipeline_destroy(sub->inner);
+    free(sub);
+}
+
 scommand scommand_new(void){
     scommand self = malloc(sizeof(struct scommand_s));
     if (self != NULL) {
-        self->args = g_queue_new();     //inicializa la cola de argumentos
+        self->args = (struct list_s){0}; //inicializa la lista de argumentos
         self->in = NULL;                //inicializa la redirección de entrada
         self->out = NULL;               //inicializa la redirección de salida
+        self->subs = (struct list_s){0}; //sin sustituciones de procesos
+        self->fds = (struct list_s){0};  //ni redirecciones de descriptores
     }
     return self;
 }
@@ -25,24 +85,84 @@ scommand scommand_new(void){
 scommand scommand_destroy(scommand self){
     assert (self != NULL);
 
-    if (self->args != NULL) {
-        g_queue_free_full(self->args, free);   // libera la cola y todas las cadenas dentro de ella
-    } 
+    list_free(&self->args, free);   // libera la lista y todas las cadenas dentro de ella
     free (self->in);    // libera la cadena de redirección de entrada
     free (self->out);   // libera la cadena de redirección de salida
+    list_free(&self->subs, procsub_free); // libera los pipelines internos
+    list_free(&self->fds, fdredir_free);
     free (self);       // libera el struct en si mismo
 
     return NULL;
 }
 
+scommand scommand_copy(const scommand self){
+    assert(self != NULL);
+    scommand copy = scommand_new();
+    for (unsigned int i = 0; i < self->args.len; i++) {
+        list_push(&copy->args, strdup(self->args.items[i]));
+    }
+    copy->in = self->in != NULL ? strdup(self->in) : NULL;
+    copy->out = self->out != NULL ? strdup(self->out) : NULL;
+    for (unsigned int i = 0; i < self->subs.len; i++) { // el marcador ya está entre los argumentos
+        struct procsub_s *sub = self->subs.items[i];
+        struct procsub_s *sub_copy = malloc(sizeof(struct procsub_s));
+        sub_copy->inner = pipeline_copy(sub->inner);
+        sub_copy->output = sub->output;
+        sub_copy->slot = sub->slot;
+        list_push(&copy->subs, sub_copy);
+    }
+    for (unsigned int i = 0; i < self->fds.len; i++) {
+        struct fdredir_s *redir = self->fds.items[i];
+        scommand_push_back_fdredir(copy, redir->fd, redir->kind, strdup(redir->target));
+    }
+    return copy;
+}
+
 void scommand_push_back(scommand self, char * argument){
     assert (self != NULL && argument != NULL);
-    g_queue_push_tail (self->args, argument);   // crea la copia del argumento y lo agrega al final de la cola
+    list_push(&self->args, argument);   // agrega el argumento al final de la lista
+}
+
+void scommand_push_back_procsub(scommand self, pipeline inner, bool output){
+    assert (self != NULL && inner != NULL);
+    struct procsub_s *sub = malloc(sizeof(struct procsub_s));
+    char *inner_str = pipeline_to_string(inner);
+    char *open = strmerge(output ? ">(" : "<(", inner_str);
+    sub->inner = inner;
+    sub->output = output;
+    sub->slot = self->args.len;
+
+    list_push(&self->subs, sub);
+    list_push(&self->args, strmerge(open, ")")); // el marcador ocupa el lugar del argumento, p.ej. "<(sort a.txt)"
+    free(inner_str);
+    free(open);
+}
+
+void scommand_push_back_fdredir(scommand self, int fd, fdredir_t kind, char *target){
+    assert (self != NULL && fd >= 0 && target != NULL);
+    struct fdredir_s *redir = malloc(sizeof(struct fdredir_s));
+    redir->fd = fd;
+    redir->kind = kind;
+    redir->target = target;
+    list_push(&self->fds, redir);
+}
+
+void scommand_set_fdredir_target(scommand self, unsigned int n, char *target){
+    assert (self != NULL && n < self->fds.len && target != NULL);
+    struct fdredir_s *redir = self->fds.items[n];
+    free(redir->target);
+    redir->target = target;
 }
 
 void scommand_pop_front(scommand self){
     assert (self != NULL && !scommand_is_empty (self));
-    free (g_queue_pop_head (self->args));   // libera la cadena que estaba al frente de la cola y la saca de la cola
+    free (list_take (&self->args, 0));   // libera la cadena que estaba al frente de la lista y la saca de la lista
+    for (unsigned int i = 0; i < self->subs.len; i++) { // los argumentos de las sustituciones se corren uno
+        struct procsub_s *sub = self->subs.items[i];
+        if (sub->slot != UINT_MAX) {
+            sub->slot = sub->slot > 0 ? sub->slot - 1 : UINT_MAX;
+        }
+    }
 }
 
 void scommand_set_redir_in(scommand self, char * filename){
@@ -67,20 +187,25 @@ void scommand_set_redir_out(scommand self, char * filename){
 
 bool scommand_is_empty(const scommand self){
     assert(self != NULL);
-    return g_queue_is_empty(self->args);    //devuelve true si la cola de argumentos está vacía
+    return self->args.len == 0;    //devuelve true si la lista de argumentos está vacía
 }
 
 unsigned int scommand_length(const scommand self){
     assert(self != NULL);
-    return g_queue_get_length(self->args);  //devuelve la cantidad de elementos en la cola de argumentos
+    return self->args.len;  //devuelve la cantidad de elementos en la lista de argumentos
 }
 
 char * scommand_front(const scommand self){
     assert(self != NULL && !scommand_is_empty(self));
-    char * result = g_queue_peek_head(self->args);  //devuelve el primer elemento de la cola de argumentos sin sacarlo
+    char * result = self->args.items[0];  //devuelve el primer elemento de la lista de argumentos sin sacarlo
     return result;
 }
 
+char * scommand_nth(const scommand self, unsigned int n){
+    assert(self != NULL && n < scommand_length(self));
+    return self->args.items[n];    //devuelve el n-ésimo elemento sin sacarlo
+}
+
 char * scommand_get_redir_in(const scommand self){
     assert(self != NULL);
     return self->in;    //devuelve la cadena de redirección de entrada (o NULL si no hay redirección)
@@ -91,16 +216,52 @@ char * scommand_get_redir_out(const scommand self){
     return self->out;   //devuelve la cadena de redirección de salida (o NULL si no hay redirección)
 }
 
+unsigned int scommand_procsub_count(const scommand self){
+    assert(self != NULL);
+    return self->subs.len;
+}
+
+pipeline scommand_get_procsub(const scommand self, unsigned int n,
+                              bool *output, unsigned int *slot){
+    assert(self != NULL && n < scommand_procsub_count(self));
+    assert(output != NULL && slot != NULL);
+    struct procsub_s *sub = self->subs.items[n];
+    *output = sub->output;
+    *slot = sub->slot;
+    return sub->inner;
+}
+
+void scommand_set_procsub_slot(scommand self, unsigned int n, unsigned int slot){
+    assert(self != NULL && n < scommand_procsub_count(self));
+    struct procsub_s *sub = self->subs.items[n];
+    sub->slot = slot;
+}
+
+unsigned int scommand_fdredir_count(const scommand self){
+    assert(self != NULL);
+    return self->fds.len;
+}
+
+fdredir_t scommand_get_fdredir(const scommand self, unsigned int n,
+                               int *fd, char **target){
+    assert(self != NULL && n < scommand_fdredir_count(self));
+    assert(fd != NULL && target != NULL);
+    struct fdredir_s *redir = self->fds.items[n];
+    *fd = redir->fd;
+    *target = redir->target;
+    return redir->kind;
+}
+
 char * scommand_to_string(const scommand self) {
     assert(self != NULL);
     char * arg = calloc(1, sizeof(char)); // representación temporal del comando simple
 
-    for (guint i = 0; i < g_queue_get_length(self->args); i++) {
-        char * current_arg = g_queue_peek_nth(self->args, i);
+    for (unsigned int i = 0; i < self->args.len; i++) {
+        char * current_arg = self->args.items[i];
         char * tmp = strmerge(arg, current_arg); // agrega el argumento actual a la representación
         free(arg);
         arg = tmp;
-        if (i < g_queue_get_length(self->args) - 1) { // 
+        if (i < self->args.len - 1) { // 
             tmp = strmerge(arg, " "); // agrega un espacio solo entre argumentos
             free(arg);
             arg = tmp;
@@ -125,20 +286,47 @@ char * scommand_to_string(const scommand self) {
         arg = tmp;
     }
 
+    for (unsigned int i = 0; i < self->fds.len; i++) { // p.ej. " 2>&1" o " 1>>log"
+        static const char *const ops[] = {"<", ">", ">>", ">&"};
+        struct fdredir_s *redir = self->fds.items[i];
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), " %d%s", redir->fd, ops[redir->kind]);
+        char * tmp = strmerge(arg, prefix);
+        free(arg);
+        arg = tmp;
+        tmp = strmerge(arg, redir->target);
+        free(arg);
+        arg = tmp;
+    }
+
 
     return arg;
 }
 
 struct pipeline_s { 
-    GSList * comms; 
+    struct list_s comms; 
+    struct list_s fanout;    // consumidores de p |& {c1, c2, ...}
     bool wait; 
+    unsigned long timeout_ms; // plazo para terminar (0: sin plazo)
+    placement_t place;        // CPUs, prioridad y cgroup de sus procesos
 };
 
+static void pipeline_free(void *data) {
+    pipeline_destroy(data);
+}
+
+static void scommand_free(void *data) {
+    scommand_destroy(data);
+}
+
 pipeline pipeline_new(void){
     pipeline p =(pipeline)malloc(sizeof(struct pipeline_s));
     if (p != NULL) {
-        p->comms = NULL;    
+        p->comms = (struct list_s){0};    
+        p->fanout = (struct list_s){0};   //sin reparto de salida
         p->wait = true;     //por defecto, el pipeline espera     
+        p->timeout_ms = 0;  //y no tiene plazo
+        placement_init(&p->place);
     }
     return p;               //si no hay memoria suficiente, devuelve NULL directamente
 }
@@ -146,24 +334,52 @@ pipeline pipeline_new(void){
 pipeline pipeline_destroy(pipeline self){
     assert(self != NULL);
 
-    g_slist_free_full(self->comms, free); // libera cada scommand correctamente
+    list_free(&self->comms, scommand_free); // libera cada scommand correctamente
+    list_free(&self->fanout, pipeline_free); // y cada consumidor del reparto
+    placement_clear(&self->place);
     free(self);
 
     return NULL;
 }
 
+pipeline pipeline_copy(const pipeline self){
+    assert(self != NULL);
+    pipeline copy = pipeline_new();
+    for (unsigned int i = 0; i < self->comms.len; i++) {
+        list_push(&copy->comms, scommand_copy(self->comms.items[i]));
+    }
+    for (unsigned int i = 0; i < self->fanout.len; i++) {
+        list_push(&copy->fanout, pipeline_copy(self->fanout.items[i]));
+    }
+    copy->wait = self->wait;
+    copy->timeout_ms = self->timeout_ms;
+    copy->place = self->place;
+    copy->place.cgroup = self->place.cgroup != NULL ? strdup(self->place.cgroup) : NULL;
+    copy->place.spec = self->place.spec != NULL ? strdup(self->place.spec) : NULL;
+    return copy;
+}
+
 void pipeline_push_back(pipeline self, scommand sc) {
     assert(self != NULL && sc != NULL);
 
-    self->comms = g_slist_append(self->comms, sc); //self->comms apunta a la lista con el comando agregado
+    list_push(&self->comms, sc); //agrega el comando al final de la lista
 }
 
 void pipeline_pop_front(pipeline self){
     assert(self!=NULL && !pipeline_is_empty(self));
 
-    scommand_destroy(self->comms->data);    //destruye el comando simple que está en el head de la lista
-    GSList *head = self->comms;  //apunta al head de la lista
-    self->comms = g_slist_delete_link(self->comms, head);   //self->comms apunta a la lista sin el comando que estaba en el head
+    scommand_destroy(list_take(&self->comms, 0));    //saca de la lista el comando simple del frente y lo destruye
+}
+
+void pipeline_remove(pipeline self, unsigned int n){
+    assert(self != NULL && n < pipeline_length(self));
+
+    scommand_destroy(list_take(&self->comms, n));
+}
+
+void pipeline_push_fanout(pipeline self, pipeline consumer) {
+    assert(self != NULL && consumer != NULL);
+    list_push(&self->fanout, consumer);
 }
 
 void pipeline_set_wait(pipeline self, const bool w) {
@@ -172,19 +388,39 @@ void pipeline_set_wait(pipeline self, const bool w) {
     self->wait = w;     // si w es true, el pipeline debe esperar; si es false, no debe esperar
 }
 
+void pipeline_set_timeout(pipeline self, unsigned long ms) {
+    assert(self != NULL);
+    self->timeout_ms = ms;
+}
+
 bool pipeline_is_empty(const pipeline self) {
     assert(self != NULL);   
-    return self->comms == NULL;
+    return self->comms.len == 0;
 }
 
 unsigned int pipeline_length(const pipeline self) {
     assert(self != NULL);
-    return g_slist_length(self->comms);
+    return self->comms.len;
 }
 
 scommand pipeline_front(const pipeline self) {
     assert(self != NULL && !pipeline_is_empty(self));
-    return g_slist_nth_data(self->comms, 0);
+    return self->comms.items[0];
+}
+
+scommand pipeline_nth(const pipeline self, unsigned int n) {
+    assert(self != NULL && n < pipeline_length(self));
+    return self->comms.items[n];
+}
+
+unsigned int pipeline_fanout_count(const pipeline self) {
+    assert(self != NULL);
+    return self->fanout.len;
+}
+
+pipeline pipeline_get_fanout(const pipeline self, unsigned int n) {
+    assert(self != NULL && n < pipeline_fanout_count(self));
+    return self->fanout.items[n];
 }
 
 bool pipeline_get_wait(const pipeline self) {
@@ -192,17 +428,39 @@ bool pipeline_get_wait(const pipeline self) {
     return self->wait;      //devuelve true si el pipeline debe esperar, false si no debe esperar
 }
 
+unsigned long pipeline_get_timeout(const pipeline self) {
+    assert(self != NULL);
+    return self->timeout_ms;
+}
+
+placement_t * pipeline_placement(const pipeline self) {
+    assert(self != NULL);
+    return &self->place;
+}
+
 char * pipeline_to_string(const pipeline self){ 
     assert(self != NULL);
 
     if (pipeline_is_empty(self)) {
-        return g_strdup(self->wait ? "" : "&");
+        return strdup(self->wait ? "" : "&");
     }
 
     char * res = calloc(1, sizeof(char)); // inicializa cadena vacía
 
-    for (GSList * i = self->comms; i != NULL; i = i->next) {     
-        scommand sc = i->data;
+    if (self->timeout_ms > 0) { // "timeout 5000ms ..."
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "timeout %lums ", self->timeout_ms);
+        free(res);
+        res = strdup(prefix);
+    }
+    if (self->place.spec != NULL) { // "cpus 0-3 nice 5 ..."
+        char * tmp = strmerge(res, self->place.spec);
+        free(res);
+        res = tmp;
+    }
+
+    for (unsigned int i = 0; i < self->comms.len; i++) {     
+        scommand sc = self->comms.items[i];
         char * sc_str = scommand_to_string(sc); 
 
         char * tmp = strmerge(res, (sc_str && sc_str[0] != '\0') ? sc_str : "<empty-cmd>");
@@ -210,13 +468,27 @@ char * pipeline_to_string(const pipeline self){
         res = tmp;
         free(sc_str);
 
-        if (i->next != NULL) {
+        if (i + 1 < self->comms.len) {
             tmp = strmerge(res, " | ");
             free(res);
             res = tmp;
         }
     }
 
+    for (unsigned int i = 0; i < self->fanout.len; i++) { // " |& {c1, c2}"
+        char * c_str = pipeline_to_string(self->fanout.items[i]);
+        char * tmp = strmerge(res, i == 0 ? " |& {" : ", ");
+        free(res);
+        res = strmerge(tmp, c_str);
+        free(tmp);
+        free(c_str);
+        if (i + 1 == self->fanout.len) {
+            tmp = strmerge(res, "}");
+            free(res);
+            res = tmp;
+        }
+    }
+
     if (!self->wait) {
         char * tmp = strmerge(res, " &");
         free(res);
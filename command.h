@@ -8,7 +8,17 @@
 #define COMMAND_H
 
 #include <stdbool.h> /* para tener bool */
+#include "placement.h"
 
+typedef struct scommand_s * scommand;
+typedef struct pipeline_s * pipeline;
+
+typedef enum {
+    FDREDIR_READ,   // N<archivo
+    FDREDIR_WRITE,  // N>archivo
+    FDREDIR_APPEND, // N>>archivo (>>archivo es 1>>archivo)
+    FDREDIR_DUP     // N>&M o N<&M: N pasa a ser una copia de M; con "-", se cierra
+} fdredir_t;
 
 /* scommand: comando simple.
  * Ejemplo: ls -l ej1.c > out < in
@@ -16,6 +26,8 @@
  * comando y desde la segunda se denominan argumentos.
  * Almacena dos cadenas que representan los redirectores de entrada y salida.
  * Cualquiera de ellos puede estar NULL indicando que no hay redirección.
+ * Las redirecciones de otros descriptores (2>err, >>log, 2>&1) van en una
+ * lista aparte, en el orden en que aparecen.
  *
  * En general, todas las operaciones hacen que el TAD adquiera propiedad de
  * los argumentos que le pasan. Es decir, el llamador queda desligado de la
@@ -30,8 +42,6 @@
  * agrega dos accesores/modificadores para redirección de entrada y salida.
  */
 
-typedef struct scommand_s * scommand;
-
 scommand scommand_new(void);
 /*
  * Nuevo `scommand', sin comandos o argumentos y los redirectores vacíos
@@ -49,6 +59,15 @@ scommand scommand_destroy(scommand self);
  * Ensures: result == NULL
  */
 
+scommand scommand_copy(const scommand self);
+/*
+ * Copia profunda de `self': argumentos, redirecciones y sustituciones de
+ * procesos con sus pipelines internos.
+ *   self: comando simple a copiar.
+ * Requires: self != NULL
+ * Ensures: result != NULL && scommand_length(result) == scommand_length(self)
+ */
+
 /* Modificadores */
 
 void scommand_push_back(scommand self, char * argument);
@@ -60,9 +79,41 @@ void scommand_push_back(scommand self, char * argument);
  * Ensures: !scommand_is_empty()
  */
 
+void scommand_push_back_procsub(scommand self, pipeline inner, bool output);
+/*
+ * Agrega por detrás un argumento de sustitución de procesos, <(inner) o
+ * >(inner). En la secuencia de cadenas queda un marcador con el texto del
+ * pipeline interno, que al ejecutar se reemplaza por /dev/fd/N. La
+ * sustitución recuerda el lugar del marcador, no su texto: un argumento
+ * común igual al marcador sigue siendo un argumento común.
+ *   self: comando simple al cual agregarle la sustitución.
+ *   inner: pipeline a correr concurrentemente. El TAD se apropia de él.
+ *   output: true para >(inner) (el comando escribe en inner), false para
+ *     <(inner) (el comando lee la salida de inner).
+ * Requires: self!=NULL && inner!=NULL
+ * Ensures: !scommand_is_empty() && scommand_procsub_count(self) aumenta en 1
+ */
+
+void scommand_push_back_fdredir(scommand self, int fd, fdredir_t kind,
+                                char *target);
+/*
+ * Agrega al final una redirección del descriptor `fd'. La cadena `target'
+ * (archivo, o descriptor de N>&M) pasa a ser propiedad del TAD.
+ * Requires: self!=NULL && fd>=0 && target!=NULL
+ */
+
+void scommand_set_fdredir_target(scommand self, unsigned int n, char *target);
+/*
+ * Reemplaza el destino de la n-ésima redirección de descriptores (p.ej.
+ * por el ya expandido). La cadena pasa a ser propiedad del TAD.
+ * Requires: self!=NULL && n < scommand_fdredir_count(self) && target!=NULL
+ */
+
 void scommand_pop_front(scommand self);
 /*
- * Quita la cadena de adelante de la secuencia de cadenas.
+ * Quita la cadena de adelante de la secuencia de cadenas. Los lugares de
+ * los marcadores de sustituciones se corren uno hacia adelante (si se quita
+ * un marcador, su sustitución queda sin lugar: UINT_MAX).
  *   self: comando simple al cual sacarle la cadena del frente.
  * Requires: self!=NULL && !scommand_is_empty(self)
  */
@@ -108,6 +159,15 @@ char * scommand_front(const scommand self);
  * Ensures: result!=NULL
  */
 
+char * scommand_nth(const scommand self, unsigned int n);
+/*
+ * Toma la n-ésima cadena de la secuencia (0 es la del frente).
+ *   Returns: la cadena, con las mismas reglas de propiedad que
+ *     scommand_front().
+ * Requires: self!=NULL && n < scommand_length(self)
+ * Ensures: result!=NULL
+ */
+
 char * scommand_get_redir_in(const scommand self);
 char * scommand_get_redir_out(const scommand self);
 /*
@@ -118,6 +178,50 @@ char * scommand_get_redir_out(const scommand self);
  * Requires: self!=NULL
  */
 
+unsigned int scommand_procsub_count(const scommand self);
+/*
+ * Da la cantidad de sustituciones de procesos del comando simple.
+ * Requires: self!=NULL
+ */
+
+pipeline scommand_get_procsub(const scommand self, unsigned int n,
+                              bool *output, unsigned int *slot);
+/*
+ * Obtiene la n-ésima sustitución de procesos (en orden de aparición).
+ *   output: se guarda si es >(...) (true) o <(...) (false).
+ *   slot: se guarda el índice en la secuencia de cadenas del marcador que
+ *     la representa, o UINT_MAX si ya no está.
+ *   Returns: el pipeline interno, que sigue siendo propiedad del TAD.
+ * Requires: self!=NULL && n < scommand_procsub_count(self) &&
+ *   output!=NULL && slot!=NULL
+ */
+
+void scommand_set_procsub_slot(scommand self, unsigned int n, unsigned int slot);
+/*
+ * Cambia el lugar del marcador de la n-ésima sustitución, p.ej. después de
+ * expandir los argumentos que tiene antes.
+ * Requires: self!=NULL && n < scommand_procsub_count(self)
+ */
+
+unsigned int scommand_fdredir_count(const scommand self);
+/*
+ * Da la cantidad de redirecciones de descriptores (N>archivo, N>>archivo,
+ * N<archivo, N>&M) del comando simple.
+ * Requires: self!=NULL
+ */
+
+fdredir_t scommand_get_fdredir(const scommand self, unsigned int n,
+                               int *fd, char **target);
+/*
+ * Obtiene la n-ésima redirección de descriptores (en orden de aparición).
+ *   fd: se guarda el descriptor que se redirige (la N).
+ *   target: se guarda el archivo, o la M de N>&M ("-" para cerrar N).
+ *     Sigue siendo propiedad del TAD.
+ *   Returns: el tipo de redirección.
+ * Requires: self!=NULL && n < scommand_fdredir_count(self) &&
+ *   fd!=NULL && target!=NULL
+ */
+
 char * scommand_to_string(const scommand self);
 /* Preety printer para hacer debugging/logging.
  * Genera una representación del comando simple en un string (aka "serializar")
@@ -150,8 +254,6 @@ char * scommand_to_string(const scommand self);
  *           ------------------------------
  */
 
-typedef struct pipeline_s * pipeline;
-
 pipeline pipeline_new(void);
 /*
  * Nuevo `pipeline', sin comandos simples y establecido para que espere.
@@ -169,6 +271,14 @@ pipeline pipeline_destroy(pipeline self);
  * Ensures: result == NULL
  */
 
+pipeline pipeline_copy(const pipeline self);
+/*
+ * Copia profunda de `self': comandos, reparto, espera, plazo y ubicación.
+ *   self: tubería a copiar.
+ * Requires: self != NULL
+ * Ensures: result != NULL && pipeline_length(result) == pipeline_length(self)
+ */
+
 /* Modificadores */
 
 void pipeline_push_back(pipeline self, scommand sc);
@@ -188,6 +298,24 @@ void pipeline_pop_front(pipeline self);
  * Requires: self!=NULL && !pipeline_is_empty(self)
  */
 
+void pipeline_remove(pipeline self, unsigned int n);
+/*
+ * Quita el n-ésimo comando simple de la secuencia (0 es el del frente).
+ *   self: pipeline al cual sacarle el comando simple.
+ *      Destruye el comando extraido.
+ * Requires: self!=NULL && n < pipeline_length(self)
+ */
+
+void pipeline_push_fanout(pipeline self, pipeline consumer);
+/*
+ * Agrega un consumidor al reparto de salida del pipeline (p1 |& {c1, c2}).
+ * La salida del último comando simple se duplica hacia cada consumidor.
+ *   self: pipeline productor.
+ *   consumer: pipeline consumidor. El TAD se apropia de él.
+ * Requires: self!=NULL && consumer!=NULL
+ * Ensures: pipeline_fanout_count(self) aumenta en 1
+ */
+
 void pipeline_set_wait(pipeline self, const bool w);
 /*
  * Define si el pipeline tiene que esperar o no.
@@ -195,6 +323,14 @@ void pipeline_set_wait(pipeline self, const bool w);
  * Requires: self!=NULL
  */
 
+void pipeline_set_timeout(pipeline self, unsigned long ms);
+/*
+ * Define el plazo para que termine el pipeline (prefijo `timeout 5s').
+ *   self: pipeline a limitar.
+ *   ms: plazo en milisegundos; 0 quita el plazo.
+ * Requires: self!=NULL
+ */
+
 /* Proyectores */
 
 bool pipeline_is_empty(const pipeline self);
@@ -227,6 +363,28 @@ scommand pipeline_front(const pipeline self);
  * Ensures: result!=NULL
  */
 
+unsigned int pipeline_fanout_count(const pipeline self);
+/*
+ * Da la cantidad de consumidores del reparto de salida (0 si no hay reparto).
+ * Requires: self!=NULL
+ */
+
+pipeline pipeline_get_fanout(const pipeline self, unsigned int n);
+/*
+ * Devuelve el n-ésimo consumidor del reparto de salida. Sigue siendo
+ * propiedad del TAD.
+ * Requires: self!=NULL && n < pipeline_fanout_count(self)
+ * Ensures: result!=NULL
+ */
+
+scommand pipeline_nth(const pipeline self, unsigned int n);
+/*
+ * Devuelve el n-ésimo comando simple de la secuencia (0 es el del frente).
+ *   Returns: el comando simple, que sigue siendo propiedad del TAD.
+ * Requires: self!=NULL && n < pipeline_length(self)
+ * Ensures: result!=NULL
+ */
+
 bool pipeline_get_wait(const pipeline self);
 /*
  * Consulta si el pipeline tiene que esperar o no.
@@ -235,6 +393,23 @@ bool pipeline_get_wait(const pipeline self);
  * Requires: self!=NULL
  */
 
+unsigned long pipeline_get_timeout(const pipeline self);
+/*
+ * Consulta el plazo del pipeline.
+ *   Returns: plazo en milisegundos, o 0 si no tiene.
+ * Requires: self!=NULL
+ */
+
+placement_t * pipeline_placement(const pipeline self);
+/*
+ * Devuelve dónde tiene que correr el pipeline (prefijos cpus, nice, ionice
+ * y cgroup).
+ *   Returns: la ubicación, que sigue siendo propiedad del TAD. El llamador
+ *     puede modificarla.
+ * Requires: self!=NULL
+ * Ensures: result!=NULL
+ */
+
 char * pipeline_to_string(const pipeline self);
 /* Pretty printer para hacer debugging/logging.
  * Genera una representación del pipeline en una cadena (aka "serializar").
@@ -0,0 +1,145 @@
+#define _GNU_SOURCE     /* pipe2() */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "coproc.h"
+#include "flow.h"
+#include "options.h"
+#include "redir.h"
+#include "vars.h"
+
+struct coproc_s {
+    char *name;
+    pid_t pid;
+};
+
+static struct coproc_s *coprocs = NULL; // los que siguen vivos
+static unsigned int ncoprocs = 0;
+
+static void set_var(const char *name, const char *suffix, long value) { // NOMBRE_0, NOMBRE_PID, ...
+    char var[256];
+    char text[32];
+    snprintf(var, sizeof(var), "%s_%s", name, suffix);
+    snprintf(text, sizeof(text), "%ld", value);
+    vars_set(var, text);
+}
+
+static void run_child(scommand cmd, int to[2], int from[2]) {
+    // en el hijo: la entrada y la salida son los pipes, y el comando corre
+    // como cualquier otro pipeline (con fork y exec, o en este mismo
+    // proceso si es una función o un grupo)
+    setpgid(0, 0); // Ctrl-C en la terminal no le llega
+    option_set(OPT_ZYGOTE, false); // el pool es del shell, no de este proceso
+    __fpurge(stdin); // lo que el shell ya leyó del script es suyo
+    redir_inherit(cmd);
+    if (dup2(to[0], STDIN_FILENO) < 0 || dup2(from[1], STDOUT_FILENO) < 0) {
+        perror("coproc");
+        _exit(EXIT_FAILURE);
+    }
+    close(to[0]);
+    close(to[1]);
+    close(from[0]);
+    close(from[1]);
+    pipeline pipe = pipeline_new();
+    pipeline_push_back(pipe, scommand_copy(cmd));
+    int status = flow_run_pipeline(pipe);
+    fflush(stdout);
+    _exit(status);
+}
+
+int coproc_start(scommand cmd) {
+    assert(cmd != NULL && !strcmp(scommand_front(cmd), "coproc"));
+    scommand_pop_front(cmd); // Quita "coproc"
+    if (scommand_length(cmd) < 2 || !vars_valid_name(scommand_front(cmd), strlen(scommand_front(cmd)))) {
+        fprintf(stderr, "coproc: uso: coproc NOMBRE comando [argumentos]\n");
+        return EXIT_FAILURE;
+    }
+    char *name = strdup(scommand_front(cmd));
+    scommand_pop_front(cmd);
+    coproc_reap();
+    for (unsigned int i = 0; i < ncoprocs; i++) {
+        if (!strcmp(coprocs[i].name, name)) {
+            fprintf(stderr, "coproc: %s: ya hay un coproceso con ese nombre\n", name);
+            free(name);
+            return EXIT_FAILURE;
+        }
+    }
+
+    int to[2];   // el shell escribe en to[1], el coproceso lee de to[0]
+    int from[2]; // el coproceso escribe en from[1], el shell lee de from[0]
+    if (pipe2(to, O_CLOEXEC) < 0) {
+        perror("coproc: pipe");
+        free(name);
+        return EXIT_FAILURE;
+    }
+    if (pipe2(from, O_CLOEXEC) < 0) {
+        perror("coproc: pipe");
+        close(to[0]);
+        close(to[1]);
+        free(name);
+        return EXIT_FAILURE;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        run_child(cmd, to, from);
+    }
+    close(to[0]);
+    close(from[1]);
+    if (pid < 0) {
+        perror("coproc: fork");
+        close(to[1]);
+        close(from[0]);
+        free(name);
+        return EXIT_FAILURE;
+    }
+    setpgid(pid, pid);
+
+    int out_fd = redir_adopt(from[0]);
+    int in_fd = -1;
+    if (out_fd >= 0) {
+        in_fd = redir_adopt(to[1]);
+    } else {
+        close(to[1]);
+    }
+    if (in_fd < 0) { // sin descriptores libres: el coproceso ve el fin de su entrada
+        fprintf(stderr, "coproc: %s: no quedan descriptores libres entre 3 y %d\n", name, REDIR_FDS - 1);
+        if (out_fd >= 0) {
+            redir_close(out_fd);
+        }
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+        free(name);
+        return EXIT_FAILURE;
+    }
+    set_var(name, "0", out_fd);
+    set_var(name, "1", in_fd);
+    set_var(name, "PID", pid);
+    coprocs = realloc(coprocs, (ncoprocs + 1) * sizeof(struct coproc_s));
+    coprocs[ncoprocs++] = (struct coproc_s){name, pid};
+    return EXIT_SUCCESS;
+}
+
+void coproc_reap(void) {
+    unsigned int i = 0;
+    while (i < ncoprocs) {
+        pid_t r = waitpid(coprocs[i].pid, NULL, WNOHANG);
+        if (r == 0 || (r < 0 && errno == EINTR)) { // sigue corriendo
+            i++;
+            continue;
+        }
+        // terminó
+        char var[256];
+        snprintf(var, sizeof(var), "%s_PID", coprocs[i].name);
+        vars_unset(var);
+        free(coprocs[i].name);
+        coprocs[i] = coprocs[--ncoprocs];
+    }
+}
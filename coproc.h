@@ -0,0 +1,39 @@
+/* Coprocesos: `coproc NOMBRE comando'.
+ *
+ * Lanza el comando una sola vez, en segundo plano, con la entrada y la
+ * salida conectadas al shell por dos pipes. Los extremos del shell quedan
+ * guardados como los de `exec' (ver redir.h), así que los comandos
+ * siguientes los reciben y se usan en cualquier redirección:
+ *
+ *   coproc BC bc -l
+ *   echo 2+2 >&$BC_1          # $NOMBRE_1: escribe en la entrada del coproceso
+ *   read -u $BC_0 r           # $NOMBRE_0: lee de su salida
+ *
+ * En $NOMBRE_PID queda su pid. Un script manda así muchos pedidos por el
+ * mismo proceso en lugar de lanzar uno por pedido. Cuando el coproceso
+ * termina se espera como cualquier otro hijo y se borra $NOMBRE_PID; sus
+ * descriptores siguen abiertos (puede quedar salida sin leer) hasta
+ * cerrarlos con `exec N>&-'.
+ */
+
+#ifndef _COPROC_H_
+#define _COPROC_H_
+
+#include "command.h"
+
+int coproc_start(scommand cmd);
+/*
+ * El comando interno coproc: lanza el resto de `cmd' (después del nombre)
+ * como coproceso. Devuelve el estado: falla si el nombre no es válido, si
+ * ya hay un coproceso vivo con ese nombre o si no quedan descriptores.
+ *
+ * REQUIRES: cmd != NULL && !strcmp(scommand_front(cmd), "coproc")
+ */
+
+void coproc_reap(void);
+/*
+ * Espera, sin bloquearse, a los coprocesos que ya terminaron y borra su
+ * $NOMBRE_PID. El shell la llama antes de cada línea.
+ */
+
+#endif
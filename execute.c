@@ -1,15 +1,30 @@
+#define _GNU_SOURCE     /* execvpe(), environ */
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <errno.h>
 #include <unistd.h>
-#include <glib.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <sys/wait.h>
 #include "tests/syscall_mock.h"
 #include "execute.h"
 #include "builtin.h"
+#include "redir.h"
 #include "parsing.h"
 #include "command.h"
+#include "fanout.h"
+#include "vars.h"
+#include "options.h"
+#include "zygote.h"
+#include "metrics.h"
+#include "flow.h"
+#include "gzredir.h"
 
 static char **scommand_to_argv(scommand self)
 {
@@ -19,92 +34,379 @@ static char **scommand_to_argv(scommand self)
     if (!argv){
         return NULL;
     }
-    // backup para poder restaurar el scommand 
-    char **backup = malloc(len * sizeof(char *));
-    if (!backup) {
-        free(argv);
-        return NULL;
-    }
-
     for (size_t i = 0; i < len; ++i) {
-        char *arg = scommand_front(self);           // obtener puntero actual
-        argv[i] = arg ? strdup(arg) : strdup("");  // argv recibe copia segura
-        backup[i] = arg ? strdup(arg) : strdup(""); // backup copia segura para restaurar
-        scommand_pop_front(self);                   // pop libera la cadena original
+        argv[i] = strdup(scommand_nth(self, (unsigned int)i)); // sin rotar: los lugares de las sustituciones no cambian
     }
     argv[len] = NULL;
 
-    for (size_t i = 0; i < len; ++i) {
-        scommand_push_back(self, backup[i]); // restaurar el scommand
+    return argv;
+}
+
+// pids de los pipelines en segundo plano que todavía no se recogieron
+static pid_t *background = NULL;
+static unsigned int n_background = 0;
+
+#define TIMEOUT_STATUS 124       // estado de un pipeline que superó su plazo, como timeout(1)
+#define TIMEOUT_GRACE_MS 2000    // tras SIGTERM, espera antes de mandar SIGKILL
+
+static void group_add(pid_t pid, pid_t *pgid, bool foreground)
+{
+    // en el padre: el primer proceso del pipeline queda como líder del
+    // grupo. El hijo hace lo mismo (placement_join_group) para no depender
+    // de cuál de los dos corre primero
+    if (*pgid < 0)
+        return;
+    setpgid(pid, *pgid);
+    if (*pgid == 0) {
+        *pgid = pid;
+        if (foreground)
+            placement_terminal_to(pid);
     }
-    free(backup); // liberamos solo el array de punteros (no las strings)
+}
 
-    return argv;
+static pid_t spawn_procsub(pipeline inner, bool output, int *parent_fd,
+                           int prev_fd, const int *sub_fds, unsigned int n_subs,
+                           pid_t *pgid, bool foreground)
+{
+    // corre `inner' concurrentemente conectado por un pipe; en *parent_fd
+    // queda el extremo que usará el comando, visible como /dev/fd/N
+    int subfd[2];
+    if (pipe(subfd) < 0) {
+        perror("pipe");
+        return -1;
+    }
+
+    fflush(stdout); // el hijo no tiene que volver a escribir lo pendiente del shell
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(subfd[0]);
+        close(subfd[1]);
+        return -1;
+    }
+    if (pid == 0) { // hijo: corre el pipeline interno
+        placement_join_group(*pgid, foreground);
+        if (prev_fd != -1) // no retener fds ajenos a la sustitución
+            close(prev_fd);
+        for (unsigned int j = 0; j < n_subs; ++j)
+            close(sub_fds[j]);
+        int ret = output ? dup2(subfd[0], STDIN_FILENO) : dup2(subfd[1], STDOUT_FILENO);
+        if (ret < 0) {
+            fprintf(stderr, "Error al conectar la sustitución de procesos: %s\n", strerror(errno));
+            _exit(1);
+        }
+        close(subfd[0]);
+        close(subfd[1]);
+        execute_pipeline(inner);
+        fflush(stdout); // lo que escribió un comando interno de `inner'
+        _exit(0);
+    }
+    group_add(pid, pgid, foreground);
+
+    if (output) { // el comando escribe en subfd[1]
+        close(subfd[0]);
+        *parent_fd = subfd[1];
+    } else {      // el comando lee de subfd[0]
+        close(subfd[1]);
+        *parent_fd = subfd[0];
+    }
+    return pid;
 }
 
+static void push_pid(pid_t **pids, unsigned int *cap, unsigned int *len, pid_t pid)
+{
+    // agrega un pid a esperar junto con el pipeline (sustituciones, consumidores)
+    if (*len >= *cap) {
+        *cap = 2 * *cap + 1;
+        *pids = realloc(*pids, *cap * sizeof(pid_t));
+    }
+    (*pids)[(*len)++] = pid;
+}
+
+static bool spawn_fanout(pipeline apipe, int in_fd, pid_t **pids,
+                         unsigned int *cap, unsigned int *len, pid_t *pgid, bool foreground)
+{
+    // lanza los consumidores de p |& {c1, c2, ...} y el proceso que les
+    // reparte lo que llega por in_fd
+    unsigned int n = pipeline_fanout_count(apipe);
+    int *out_fds = malloc(n * sizeof(int));
+    unsigned int started = 0;
+    bool ok = true;
+
+    for (unsigned int k = 0; k < n && ok; ++k) { // cada consumidor se conecta como un >(...)
+        pid_t pid = spawn_procsub(pipeline_get_fanout(apipe, k), true, &out_fds[k],
+                                  in_fd, out_fds, k, pgid, foreground);
+        if (pid < 0) {
+            ok = false;
+        } else {
+            push_pid(pids, cap, len, pid);
+            started++;
+        }
+    }
+
+    if (ok) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            ok = false;
+        } else if (pid == 0) { // hijo: reparte y termina
+            placement_join_group(*pgid, foreground);
+            fanout_run(in_fd, out_fds, n);
+            exit(0);
+        } else {
+            group_add(pid, pgid, foreground);
+            push_pid(pids, cap, len, pid);
+        }
+    }
+
+    for (unsigned int k = 0; k < started; ++k) // sólo el repartidor escribe en los consumidores
+        close(out_fds[k]);
+    free(out_fds);
+    return ok;
+}
+
+static void replace_procsub_args(scommand scom, char **argv, const int *sub_fds)
+{
+    // reemplaza cada marcador <(...) / >(...) de argv por /dev/fd/N
+    unsigned int nsubs = scommand_procsub_count(scom);
+    unsigned int argc = scommand_length(scom);
+    for (unsigned int n = 0; n < nsubs; ++n) {
+        bool output;
+        unsigned int slot;
+        scommand_get_procsub(scom, n, &output, &slot);
+        if (slot >= argc)
+            continue; // el marcador se quitó (p.ej. era el prefijo)
+        free(argv[slot]);
+        argv[slot] = malloc(32);
+        snprintf(argv[slot], 32, "/dev/fd/%d", sub_fds[n]);
+    }
+}
+
+
+static int wait_status(int raw)
+{
+    // estado de salida como en bash: el código de exit, o 128 + señal
+    if (WIFEXITED(raw))
+        return WEXITSTATUS(raw);
+    if (WIFSIGNALED(raw))
+        return 128 + WTERMSIG(raw);
+    return EXIT_FAILURE;
+}
+
+static bool wait_stage(pid_t pid, pid_t pgid, int *raw)
+{
+    // espera a que termine `pid'. Con grupo propio Ctrl-Z detiene sólo al
+    // pipeline; como no hay control de trabajos (fg/bg) para retomarlo, se
+    // lo reanuda en vez de quedar esperando para siempre
+    while (waitpid(pid, raw, pgid > 0 ? WUNTRACED : 0) == pid) {
+        if (!WIFSTOPPED(*raw))
+            return true;
+        kill(-pgid, SIGCONT);
+    }
+    return false;
+}
+
+static int wait_deadline(const pid_t *pids, unsigned int n_pids, unsigned int last,
+                         pid_t pgid, unsigned long timeout_ms, bool *expired)
+{
+    // espera a todos los procesos a la vez con un pidfd por proceso y un
+    // timerfd para el plazo; al vencer manda SIGTERM al grupo del pipeline
+    // (o a cada proceso, si no tiene grupo propio) y, si no alcanza,
+    // SIGKILL. Devuelve el estado del proceso `last'
+    struct pollfd *fds = calloc(n_pids + 1, sizeof(struct pollfd));
+    int status = EXIT_SUCCESS;
+    unsigned int remaining = 0;
+
+    fds[0].fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    fds[0].events = POLLIN;
+    struct itimerspec deadline = {.it_value = {.tv_sec = (time_t)(timeout_ms / 1000),
+                                               .tv_nsec = (long)(timeout_ms % 1000) * 1000000}};
+    timerfd_settime(fds[0].fd, 0, &deadline, NULL);
+
+    for (unsigned int i = 0; i < n_pids; ++i) {
+        fds[i + 1].fd = pids[i] > 0 ? (int)syscall(SYS_pidfd_open, pids[i], 0) : -1;
+        fds[i + 1].events = POLLIN;
+        if (fds[i + 1].fd >= 0)
+            ++remaining;
+    }
+
+    *expired = false;
+    bool killed = false;
+    while (remaining > 0) {
+        if (poll(fds, n_pids + 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            uint64_t ticks;
+            if (read(fds[0].fd, &ticks, sizeof(ticks)) == sizeof(ticks) && !killed) {
+                int sig = *expired ? SIGKILL : SIGTERM;
+                if (pgid > 0) {
+                    kill(-pgid, sig);
+                } else { // sin grupo propio (p.ej. dentro de un grupo o de una sustitución): uno por uno
+                    for (unsigned int i = 0; i < n_pids; ++i) {
+                        if (pids[i] > 0 && fds[i + 1].fd != -2)
+                            kill(pids[i], sig);
+                    }
+                }
+                killed = *expired;
+                if (!*expired) { // segunda oportunidad antes de SIGKILL
+                    struct itimerspec grace = {.it_value = {.tv_sec = TIMEOUT_GRACE_MS / 1000,
+                                                            .tv_nsec = (TIMEOUT_GRACE_MS % 1000) * 1000000}};
+                    timerfd_settime(fds[0].fd, 0, &grace, NULL);
+                }
+                *expired = true;
+            }
+        }
+        for (unsigned int i = 0; i < n_pids; ++i) {
+            if (fds[i + 1].fd < 0 || !(fds[i + 1].revents & POLLIN))
+                continue;
+            int raw;
+            if (waitpid(pids[i], &raw, 0) == pids[i] && i == last)
+                status = wait_status(raw);
+            close(fds[i + 1].fd);
+            fds[i + 1].fd = -2; // ya esperado
+            --remaining;
+        }
+    }
+
+    for (unsigned int i = 0; i < n_pids; ++i) { // los que quedaron sin pidfd se esperan como siempre
+        if (fds[i + 1].fd >= 0)
+            close(fds[i + 1].fd);
+        int raw;
+        if (pids[i] > 0 && fds[i + 1].fd != -2 && waitpid(pids[i], &raw, 0) == pids[i] && i == last)
+            status = wait_status(raw);
+    }
+    close(fds[0].fd);
+    free(fds);
+    return status;
+}
 
-void execute_pipeline(pipeline apipe) 
+int execute_pipeline(pipeline apipe) 
 {
     assert(apipe != NULL);
 
     if (pipeline_is_empty(apipe)) {
-        return;
+        return EXIT_SUCCESS;
     }
-    if (builtin_alone(apipe)) { // si es un comando interno, lo corre
-        builtin_run(pipeline_front(apipe)); 
-        return;
+    if (builtin_alone(apipe) && pipeline_get_timeout(apipe) == 0) { // si es un comando interno, lo corre
+        return builtin_run(pipeline_front(apipe)); // (con plazo va en un hijo, como en un pipeline)
     }
 
-    if (!pipeline_get_wait(apipe)) { // evita zombies ignorando SIGCHLD si no se espera a los hijos
-        signal(SIGCHLD, SIG_IGN);
-    }
+    metrics_count(METRIC_PIPELINES);
 
     int total = pipeline_length(apipe);
-    pid_t *pids = calloc(total, sizeof(pid_t)); // array para guardar los pids de los hijos
+    unsigned int n_fanout = pipeline_fanout_count(apipe);
+    unsigned int pids_cap = total;
+    unsigned int n_pids = total; // los primeros `total' son los de cada comando
+    pid_t *pids = calloc(pids_cap, sizeof(pid_t)); // array para guardar los pids de los hijos (y de las sustituciones)
     if (pids == NULL)
     {
         perror("calloc");
-        return;
+        return EXIT_FAILURE;
     }
 
     int prev_fd = -1;
     bool error = false;
 
+    // en una sesión interactiva cada pipeline va en su propio grupo de
+    // procesos, que recibe la terminal si se lo espera (así Ctrl-C le llega
+    // sólo a él); con plazo también, para poder terminarlo entero. Un
+    // pipeline anidado queda en el grupo del que lo lanzó
+    unsigned long timeout_ms = pipeline_get_wait(apipe) ? pipeline_get_timeout(apipe) : 0;
+    bool interactive = !placement_in_group() && isatty(STDIN_FILENO) &&
+                       tcgetpgrp(STDIN_FILENO) == getpgrp();
+    pid_t pgid = (interactive || (timeout_ms > 0 && !placement_in_group())) ? 0 : -1;
+    bool foreground = interactive && pipeline_get_wait(apipe);
+    placement_t *place = pipeline_placement(apipe);
+    gzredir *gz = NULL; // hilos de < x.gz y > x.gz, se esperan con el pipeline
+    unsigned int n_gz = 0;
+
     for (int i = 0; i < total; ++i) {
         if (error) {
-            return;
+            break;
         } // descartar comandos restantes
 
         scommand scom = pipeline_front(apipe); // obtener el siguiente comando
-        if (builtin_is_internal(scom))
-        {
-            error = true;
-            break;
-        }
-        bool keep_going = (i < total - 1); // si hay más comandos, crear pipe
+        bool keep_going = (i < total - 1) || n_fanout > 0; // si hay más comandos o reparto, crear pipe
         int pipefd[2] = {-1, -1}; // inicializar pipe para no tener basura
 
-        if (keep_going) { 
+        // sustituciones de procesos: se lanzan antes del comando que las usa
+        unsigned int nsubs = scommand_procsub_count(scom);
+        int *sub_fds = malloc((nsubs + 1) * sizeof(int));
+        for (unsigned int n = 0; n < nsubs; ++n)
+            sub_fds[n] = -1;
+        for (unsigned int n = 0; n < nsubs && !error; ++n) {
+            bool output;
+            unsigned int slot;
+            pipeline inner = scommand_get_procsub(scom, n, &output, &slot);
+            pid_t sub_pid = spawn_procsub(inner, output, &sub_fds[n], prev_fd, sub_fds, n,
+                                          &pgid, foreground);
+            if (sub_pid < 0) {
+                error = true;
+            } else {
+                push_pid(&pids, &pids_cap, &n_pids, sub_pid); // se esperan junto con el pipeline
+            }
+        }
+
+        // < x.gz y > x.gz (set -o gzip): el comando recibe un pipe con un hilo que comprime del otro lado
+        int gz_fds[2] = {-1, -1};
+        char *gz_paths[2] = {scommand_get_redir_in(scom), scommand_get_redir_out(scom)};
+        for (int k = 0; k < 2 && !error; ++k) {
+            if (gz_paths[k] != NULL && gzredir_wanted(gz_paths[k])) {
+                gzredir job = gzredir_start(gz_paths[k], k == 1, &gz_fds[k]);
+                if (job == NULL) {
+                    error = true;
+                } else {
+                    gz = realloc(gz, (n_gz + 1) * sizeof(gzredir));
+                    gz[n_gz++] = job;
+                }
+            }
+        }
+
+        if (keep_going && !error) { 
             if (pipe(pipefd) < 0) { // crear pipe
                 perror("pipe");
                 if (prev_fd != -1)
                     close(prev_fd); // cerrar fd previo si existe
+                prev_fd = -1;
                 error = true;
             }
         }
 
         if (!error) {
-            pid_t pid = fork(); // crear proceso hijo
+            uint64_t spawn_start = metrics_now();
+            pid_t pid = -1;
+            // sin sustituciones ni descriptores extra lo puede lanzar el pool
+            if (nsubs == 0 && !redir_pending(scom) && !flow_is_group(scom) && !flow_is_function(scom) &&
+                !builtin_is_internal(scom) && gz_fds[0] < 0 && gz_fds[1] < 0 && option_get(OPT_ZYGOTE)) {
+                pid = zygote_spawn(scom, prev_fd, keep_going ? pipefd[1] : -1,
+                                   pgid, foreground, place);
+            }
+            if (pid < 0) {
+                fflush(stdout); // un grupo ( ... ) en el hijo vacía su stdout al terminar: que no
+                fflush(stderr); // repita lo que el shell tenía pendiente
+                pid = fork(); // crear proceso hijo
+            }
             if (pid < 0) {
                 perror("fork");
+                metrics_count(METRIC_SPAWN_FAILURES);
                 if (prev_fd != -1) // cerrar fd previo si existe
                     close(prev_fd);
+                prev_fd = -1;
                 if (keep_going) { // cerrar pipe si se creó
                     close(pipefd[0]);
                     close(pipefd[1]);
                 }
                 error = true;
             } else if (pid == 0) { // hijo
+                placement_join_group(pgid, foreground);
+                if (!placement_apply(place))
+                    exit(1);
+                redir_inherit(scom); // descriptores de exec N>archivo
+
                 // stdin desde prev_fd si existe 
                 if (prev_fd != -1) {
                     int ret = dup2(prev_fd, STDIN_FILENO);
@@ -125,7 +427,12 @@ void execute_pipeline(pipeline apipe)
 
                 /* redirecciones de archivo */
                 char *redir_in = scommand_get_redir_in(scom);
-                if (redir_in != NULL) {
+                if (gz_fds[0] != -1) {
+                    if (dup2(gz_fds[0], STDIN_FILENO) < 0) {
+                        fprintf(stderr, "Error al redirigir la entrada desde '%s': %s\n", redir_in, strerror(errno));
+                        exit(1);
+                    }
+                } else if (redir_in != NULL) {
                     int fd = open(redir_in, O_RDONLY, 0666);
                     if (fd < 0) {
                         fprintf(stderr, "Error al abrir archivo de entrada '%s': %s\n", redir_in, strerror(errno));
@@ -141,7 +448,12 @@ void execute_pipeline(pipeline apipe)
                 }
 
                 char *redir_out = scommand_get_redir_out(scom);
-                if (redir_out != NULL) {
+                if (gz_fds[1] != -1) {
+                    if (dup2(gz_fds[1], STDOUT_FILENO) < 0) {
+                        fprintf(stderr, "Error al redirigir la salida hacia '%s': %s\n", redir_out, strerror(errno));
+                        exit(1);
+                    }
+                } else if (redir_out != NULL) {
                     int fd = open(redir_out, O_WRONLY | O_CREAT | O_TRUNC, 0666);
                     if (fd < 0) {
                         fprintf(stderr, "Error al abrir archivo de salida '%s': %s\n", redir_out, strerror(errno));
@@ -155,6 +467,8 @@ void execute_pipeline(pipeline apipe)
                     }
                     close(fd);
                 }
+                if (!redir_apply(scom)) // 2>err, >>log, 2>&1, ...
+                    exit(1);
                 if (prev_fd != -1) 
                     close(prev_fd);
                 if (keep_going) {
@@ -162,20 +476,46 @@ void execute_pipeline(pipeline apipe)
                     close(pipefd[1]);
                 }
 
+                if (flow_is_group(scom)) // { ...; } | cmd, ( ... ): no termina acá
+                    flow_group_exec(scom);
+                if (flow_is_function(scom)) // f | cat, timeout 1 f
+                    flow_function_exec(scom);
+                if (builtin_is_internal(scom)) // stats | head: corre en este hijo
+                    builtin_exec(scom);
+
                 char **argv = scommand_to_argv(scom); 
                 if (!argv) {
                     perror("scommand_to_argv");
                     exit(1);
                 }
+                replace_procsub_args(scom, argv, sub_fds);
 
-                execvp(argv[0], argv);
-                fprintf(stderr, "%s: comando no encontrado.\n", argv[0]);
+                // A=1 B=2 cmd: las asignaciones iniciales sólo valen para el comando
+                size_t skip = 0;
+                while (argv[skip] != NULL && argv[skip + 1] != NULL && vars_is_assignment(argv[skip])) {
+                    char *eq = strchr(argv[skip], '=');
+                    *eq = '\0';
+                    vars_set(argv[skip], eq + 1);
+                    vars_export(argv[skip]);
+                    ++skip;
+                }
+
+                environ = vars_envp(); // también lo usa execvpe para buscar en $PATH
+                execvpe(argv[skip], argv + skip, environ);
+                fprintf(stderr, "%s: comando no encontrado.\n", argv[skip]);
                 for (size_t j = 0; argv[j] != NULL; ++j)
                     free(argv[j]);
                 free(argv);
                 exit(1);
             } else { /* padre */
+                metrics_observe(METRIC_SPAWN, spawn_start);
+                metrics_count(METRIC_STAGES);
                 pids[i] = pid; // guardar pid del hijo
+                group_add(pid, &pgid, foreground);
+                for (unsigned int n = 0; n < nsubs; ++n) { // el hijo ya heredó los extremos de las sustituciones
+                    if (sub_fds[n] != -1)
+                        close(sub_fds[n]);
+                }
                 if (prev_fd != -1) { // cerrar fd previo si existe
                     close(prev_fd);
                 }
@@ -186,19 +526,78 @@ void execute_pipeline(pipeline apipe)
                 }
             }
         }
+        for (int k = 0; k < 2; ++k) { // el hijo ya tiene su extremo; el hilo ve el fin cuando termina
+            if (gz_fds[k] != -1)
+                close(gz_fds[k]);
+        }
+        if (error) { // no quedan sustituciones abiertas si el comando no se lanzó
+            for (unsigned int n = 0; n < nsubs; ++n) {
+                if (sub_fds[n] != -1)
+                    close(sub_fds[n]);
+            }
+        }
+        free(sub_fds);
         pipeline_pop_front(apipe); // descartar comando ya procesado
     }
 
+    if (n_fanout > 0 && !error && prev_fd != -1) { // repartir la salida del último comando
+        spawn_fanout(apipe, prev_fd, &pids, &pids_cap, &n_pids, &pgid, foreground);
+    }
+
     if (prev_fd != -1) {
         close(prev_fd);
     } // cerrar último fd si existe
 
-    if (!error && pipeline_get_wait(apipe)) { // esperar a todos los hijos si corresponde
-        for (int i = 0; i < total; ++i) {
+    int status = error ? EXIT_FAILURE : EXIT_SUCCESS;
+    uint64_t wait_start = metrics_now();
+    if (timeout_ms > 0) { // esperar con plazo
+        bool expired;
+        int last = wait_deadline(pids, n_pids, (unsigned int)total - 1, pgid, timeout_ms, &expired);
+        if (expired) {
+            fprintf(stderr, "timeout: el pipeline no terminó en %lu ms\n", timeout_ms);
+            status = TIMEOUT_STATUS;
+        } else if (!error) {
+            status = last;
+        }
+        if (foreground && pgid > 0)
+            placement_terminal_to(getpgrp()); // el shell recupera la terminal
+        metrics_observe(METRIC_WAIT, wait_start);
+    } else if (pipeline_get_wait(apipe)) { // esperar a todos los hijos si corresponde
+        for (unsigned int i = 0; i < n_pids; ++i) {
+            int raw;
+            if (pids[i] > 0 && wait_stage(pids[i], pgid, &raw) &&
+                i == (unsigned int)total - 1 && !error) {
+                status = wait_status(raw); // el estado del pipeline es el del último comando
+            }
+        }
+        if (foreground && pgid > 0)
+            placement_terminal_to(getpgrp()); // el shell recupera la terminal
+        metrics_observe(METRIC_WAIT, wait_start);
+    } else { // en segundo plano: los recoge execute_reap()
+        execute_reap();
+        background = realloc(background, (n_background + n_pids) * sizeof(pid_t));
+        for (unsigned int i = 0; i < n_pids; ++i) {
             if (pids[i] > 0)
-                waitpid(pids[i], NULL, 0);
+                background[n_background++] = pids[i];
         }
     }
 
+    for (unsigned int n = 0; n < n_gz; ++n) // el archivo .gz queda completo antes del comando siguiente
+        gzredir_finish(gz[n], pipeline_get_wait(apipe));
+    free(gz);
     free(pids);
-}
\ No newline at end of file
+    return status;
+}
+
+void execute_reap(void)
+{
+    unsigned int i = 0;
+    while (i < n_background) {
+        pid_t r = waitpid(background[i], NULL, WNOHANG);
+        if (r == 0 || (r < 0 && errno == EINTR)) { // sigue corriendo
+            ++i;
+            continue;
+        }
+        background[i] = background[--n_background];
+    }
+}
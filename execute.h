@@ -8,13 +8,21 @@
 #include "command.h"
 
 
-void execute_pipeline(pipeline apipe);
+int execute_pipeline(pipeline apipe);
 /*
  * Ejecuta un pipeline, identificando comandos internos, forkeando, y
  *   redirigiendo la entrada y salida. puede modificar `apipe' en el proceso
  *   de ejecución.
  *   apipe: pipeline a ejecutar
+ *   Returns: estado de salida del último comando (128 + número de señal si
+ *     lo terminó una señal), o 0 si el pipeline corre en segundo plano.
  * Requires: apipe!=NULL
  */
 
+void execute_reap(void);
+/*
+ * Recoge, sin esperar, los procesos de los pipelines en segundo plano que
+ *   ya terminaron, para que no queden zombies. Se llama entre línea y línea.
+ */
+
 #endif /* EXECUTE_H */
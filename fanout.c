@@ -0,0 +1,161 @@
+#define _GNU_SOURCE     /* tee(), splice() */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "fanout.h"
+
+#define FANOUT_CHUNK (64 * 1024)   // capacidad por defecto de un pipe
+
+static void drop_consumer(int *out_fds, unsigned int k, unsigned int *alive)
+{
+    close(out_fds[k]);
+    out_fds[k] = -1;
+    (*alive)--;
+}
+
+static bool write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w < 0)
+            return false;
+        buf += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+static ssize_t read_full(int fd, char *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        ssize_t r = read(fd, buf + got, len - got);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+        got += (size_t)r;
+    }
+    return (ssize_t)got;
+}
+
+static void copy_loop(int in_fd, int *out_fds, unsigned int n, unsigned int alive, char *buf)
+{
+    // camino de respaldo cuando no son pipes: copia en memoria de usuario
+    ssize_t r;
+    while (alive > 0 && (r = read(in_fd, buf, FANOUT_CHUNK)) != 0) {
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (unsigned int k = 0; k < n; ++k) {
+            if (out_fds[k] != -1 && !write_all(out_fds[k], buf, (size_t)r))
+                drop_consumer(out_fds, k, &alive);
+        }
+    }
+}
+
+void fanout_run(int in_fd, int *out_fds, unsigned int n)
+{
+    assert(in_fd >= 0 && out_fds != NULL && n > 0);
+    signal(SIGPIPE, SIG_IGN); // un consumidor que termina se detecta por EPIPE
+
+    char *buf = malloc(FANOUT_CHUNK);
+    size_t *sent = calloc(n, sizeof(size_t)); // bytes del bloque actual ya entregados a cada uno
+    unsigned int alive = n;
+    bool done = false;
+
+    while (alive > 0 && !done) {
+        unsigned int last = n; // el último consumidor vivo recibe el bloque con splice
+        for (unsigned int k = 0; k < n; ++k) {
+            if (out_fds[k] != -1)
+                last = k;
+        }
+
+        // 1) duplicar el bloque hacia todos menos `last' con tee, sin consumirlo
+        ssize_t m = FANOUT_CHUNK;
+        bool first = true;
+        bool partial = false;
+        for (unsigned int k = 0; k < n && !done; ++k) {
+            if (out_fds[k] == -1 || k == last)
+                continue;
+            ssize_t t = tee(in_fd, out_fds[k], (size_t)m, 0);
+            if (t < 0 && errno == EINTR) {
+                --k; // reintentar el mismo consumidor
+                continue;
+            }
+            if (t < 0 && errno == EINVAL) { // alguno no es un pipe
+                copy_loop(in_fd, out_fds, n, alive, buf);
+                done = true;
+            } else if (t < 0) {
+                drop_consumer(out_fds, k, &alive);
+                sent[k] = 0;
+            } else if (first) {
+                if (t == 0) // fin de archivo del productor
+                    done = true;
+                m = t; // el primer tee fija el tamaño del bloque
+                sent[k] = (size_t)t;
+                first = false;
+            } else {
+                sent[k] = (size_t)t;
+                partial = partial || t < m;
+            }
+        }
+        if (done)
+            break;
+
+        // 2) consumir el bloque entregándolo a `last'
+        if (partial) { // algún pipe estaba casi lleno: completar copiando en memoria
+            ssize_t r = read_full(in_fd, buf, (size_t)m);
+            for (unsigned int k = 0; k < n && r > 0; ++k) {
+                if (out_fds[k] == -1)
+                    continue;
+                size_t from = (k == last) ? 0 : sent[k];
+                if (from < (size_t)r && !write_all(out_fds[k], buf + from, (size_t)r - from))
+                    drop_consumer(out_fds, k, &alive);
+            }
+            if (r <= 0)
+                done = true;
+        } else if (last < n) {
+            size_t left = first ? FANOUT_CHUNK : (size_t)m;
+            while (left > 0) {
+                ssize_t s = splice(in_fd, NULL, out_fds[last], NULL, left, SPLICE_F_MOVE);
+                if (s < 0 && errno == EINTR)
+                    continue;
+                if (s < 0 && errno == EINVAL) { // no son pipes
+                    copy_loop(in_fd, out_fds, n, alive, buf);
+                    done = true;
+                } else if (s < 0) { // `last' se fue: descartar lo que le tocaba
+                    drop_consumer(out_fds, last, &alive);
+                    if (!first)
+                        read_full(in_fd, buf, left);
+                } else if (s == 0) {
+                    done = true;
+                } else if (first) {
+                    left = 0; // sólo había un consumidor: cualquier cantidad sirve
+                    continue;
+                } else {
+                    left -= (size_t)s;
+                    continue;
+                }
+                left = 0;
+            }
+        }
+    }
+
+    for (unsigned int k = 0; k < n; ++k) {
+        if (out_fds[k] != -1)
+            close(out_fds[k]);
+    }
+    close(in_fd);
+    free(sent);
+    free(buf);
+}
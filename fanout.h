@@ -0,0 +1,20 @@
+/* Reparto de un flujo a varios consumidores (operador |& {c1, c2, ...}).
+ * Se ejecuta en un proceso auxiliar que forkea execute_pipeline().
+ */
+
+#ifndef _FANOUT_H_
+#define _FANOUT_H_
+
+void fanout_run(int in_fd, int *out_fds, unsigned int n);
+/*
+ * Copia todo lo que llega por `in_fd' a cada uno de los `n' descriptores de
+ * `out_fds' hasta el fin de archivo. Si los descriptores son pipes usa
+ * tee(2) y splice(2), sin copiar los datos a memoria de usuario. Las
+ * escrituras son bloqueantes, por lo que el productor avanza al ritmo del
+ * consumidor más lento. Un consumidor que cerró su pipe se descarta sin
+ * afectar al resto. Cierra `in_fd' y todos los `out_fds'.
+ *
+ * REQUIRES: in_fd >= 0 && out_fds != NULL && n > 0
+ */
+
+#endif
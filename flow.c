@@ -0,0 +1,1174 @@
+#include <assert.h>
+#include <ctype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "flow.h"
+#include "parsing.h"
+#include "builtin.h"
+#include "execute.h"
+#include "options.h"
+#include "plan.h"
+#include "vars.h"
+#include "pathexp.h"
+#include "metrics.h"
+#include "alloc.h"
+#include "redir.h"
+#include "audit.h"
+
+#define FLOW_MAX_CALLS 256   // llamadas a funciones anidadas
+
+/* Texto -> items: cada comando, o cada palabra clave con lo que la sigue */
+
+struct item_s {
+    char *word;     // palabra clave; NULL si es un comando
+    char *text;     // el comando, o el resto de la palabra clave (for, break, ...)
+};
+
+struct items_s {
+    struct item_s *v;
+    unsigned int len;
+    unsigned int cap;
+};
+
+static void items_push(struct items_s *items, const char *word, char *text) {
+    if (items->len == items->cap) {
+        items->cap = items->cap == 0 ? 16 : 2 * items->cap;
+        items->v = realloc(items->v, items->cap * sizeof(struct item_s));
+    }
+    items->v[items->len].word = word != NULL ? strdup(word) : NULL;
+    items->v[items->len].text = text;
+    items->len++;
+}
+
+static void items_free(struct items_s *items) {
+    for (unsigned int i = 0; i < items->len; i++) {
+        free(items->v[i].word);
+        free(items->v[i].text);
+    }
+    free(items->v);
+}
+
+static bool is_word(const struct item_s *item, const char *word) {
+    return item->word != NULL && !strcmp(item->word, word);
+}
+
+static char *next_segment(const char **pos) {
+    // devuelve el próximo comando de *pos, hasta un `;' o fin de línea que
+    // no esté entre comillas, sin comentarios ni blancos en los extremos;
+    // NULL al terminar el texto. Un `&' suelto también lo termina, y queda
+    // al final del comando para que corra en segundo plano (`a & b')
+    const char *s = *pos;
+    if (*s == '\0') {
+        return NULL;
+    }
+    char *seg = malloc(strlen(s) + 1);
+    size_t len = 0;
+    char quote = '\0';
+    for (; *s != '\0'; s++) {
+        if (quote == '\0' && (*s == ';' || *s == '\n')) {
+            s++;
+            break;
+        }
+        if (quote == '\0' && *s == '&' && (s == *pos || strchr("<>|&", s[-1]) == NULL) &&
+            s[1] != '&' && s[1] != '>') { // ni 2>&1, ni |&, ni &&
+            seg[len++] = *s++;
+            break;
+        }
+        if (quote == '\0' && *s == '#' && (len == 0 || isspace((unsigned char)seg[len - 1]))) {
+            while (s[1] != '\0' && s[1] != '\n') { // comentario hasta el fin de línea
+                s++;
+            }
+            continue;
+        }
+        if (*s == '\\' && quote != '\'' && s[1] != '\0') {
+            seg[len++] = *s++;
+        } else if (quote == '\0' && (*s == '\'' || *s == '"')) {
+            quote = *s;
+        } else if (*s == quote) {
+            quote = '\0';
+        }
+        seg[len++] = *s;
+    }
+    *pos = s;
+    while (len > 0 && isspace((unsigned char)seg[len - 1])) {
+        len--;
+    }
+    seg[len] = '\0';
+    size_t lead = strspn(seg, " \t");
+    memmove(seg, seg + lead, len - lead + 1);
+    return seg;
+}
+
+static char *split_word(const char *s, const char **rest) {
+    // primera palabra de `s' (con sus comillas); *rest queda en la siguiente
+    s += strspn(s, " \t");
+    const char *end = s;
+    char quote = '\0';
+    for (; *end != '\0' && (quote != '\0' || (*end != ' ' && *end != '\t')); end++) {
+        if (*end == '\\' && quote != '\'' && end[1] != '\0') {
+            end++;
+        } else if (quote == '\0' && (*end == '\'' || *end == '"')) {
+            quote = *end;
+        } else if (*end == quote) {
+            quote = '\0';
+        }
+    }
+    *rest = end + strspn(end, " \t");
+    return end > s ? strndup(s, (size_t)(end - s)) : NULL;
+}
+
+static bool one_of(const char *word, const char *const *list) {
+    for (; *list != NULL; list++) {
+        if (!strcmp(word, *list)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char *const opening[] = {"if", "elif", "while", "until", "then", "do", "else", "{", NULL};
+static const char *const closing[] = {"fi", "done", "}", NULL};
+static const char *const with_args[] = {"for", "break", "continue", "return", NULL};
+
+static bool is_redirection(const char *text) { // empieza con < archivo, > archivo, 2>&1, ...
+    text += strspn(text, "0123456789");
+    return *text == '<' || *text == '>';
+}
+
+static bool add_items(struct items_s *items, const char *text, bool report) {
+    // agrega los items de un comando; false si está mal formado (y con
+    // `report' lo informa). Las redirecciones después de fi, done o } quedan
+    // en el texto de ese item
+    const char *rest;
+    char *word = split_word(text, &rest);
+    if (word == NULL) {
+        return true;
+    }
+    size_t len = strlen(word);
+    bool ok = true;
+    if (one_of(word, opening)) { // lo que sigue es otro comando: `then echo hola'
+        items_push(items, word, NULL);
+        ok = add_items(items, rest, report);
+    } else if (one_of(word, closing)) {
+        items_push(items, word, *rest != '\0' ? strdup(rest) : NULL);
+        if (*rest != '\0' && !is_redirection(rest)) {
+            if (report) {
+                fprintf(stderr, "Error de sintaxis: '%s' después de '%s'.\n", rest, word);
+            }
+            ok = false;
+        }
+    } else if (one_of(word, with_args)) {
+        items_push(items, word, strdup(rest));
+    } else if (!strcmp(word, "function") || (len > 2 && !strcmp(word + len - 2, "()")) ||
+               !strncmp(rest, "()", 2)) {
+        // function NOMBRE [()] [{ ...], NOMBRE() [{ ...] o NOMBRE () [{ ...]
+        char *name = word;
+        if (!strcmp(word, "function")) {
+            name = split_word(rest, &rest);
+            free(word);
+            word = name;
+            if (name == NULL) {
+                if (report) {
+                    fprintf(stderr, "Error de sintaxis: falta el nombre de la función.\n");
+                }
+                return false;
+            }
+            len = strlen(name);
+        }
+        if (len > 2 && !strcmp(name + len - 2, "()")) {
+            name[len - 2] = '\0';
+        } else if (!strncmp(rest, "()", 2)) {
+            rest += 2 + strspn(rest + 2, " \t");
+        }
+        items_push(items, "function", strdup(name));
+        ok = add_items(items, rest, report);
+    } else {
+        items_push(items, NULL, strdup(text));
+    }
+    free(word);
+    return ok;
+}
+
+static bool tokenize(const char *text, struct items_s *items, bool report) {
+    *items = (struct items_s){NULL, 0, 0};
+    const char *pos = text;
+    char *seg;
+    bool ok = true;
+    while (ok && (seg = next_segment(&pos)) != NULL) {
+        ok = add_items(items, seg, report);
+        free(seg);
+    }
+    return ok;
+}
+
+/* Programa: instrucciones para el intérprete */
+
+typedef enum {
+    OP_RUN,         // copia, expande y ejecuta `pipe'
+    OP_TRUE,        // deja el estado en 0
+    OP_SAVE,        // guarda el estado, para que un ciclo termine con el de su cuerpo
+    OP_JUMP,        // salta a `target', descartando `pops' iteradores de for
+    OP_JUMP_IF,     // salta a `target' si el éxito del estado es `when'; con `restore'
+                    // recupera el estado guardado
+    OP_FOR,         // expande `words' y apila un iterador
+    OP_NEXT,        // pone en `name' la próxima palabra; si no hay, desapila y salta
+    OP_DEFINE,      // define la función `name' con el cuerpo `body'
+    OP_RETURN       // termina la función, con el estado de `words' si hay
+} op_t;
+
+struct program_s;
+
+struct instr_s {
+    op_t op;
+    pipeline pipe;
+    unsigned int *groups;   // grupos que aparecen en `pipe', que son de esta instrucción
+    unsigned int ngroups;
+    scommand words;
+    char *name;
+    struct program_s *body;
+    unsigned int target;
+    unsigned int pops;
+    bool when;
+    bool restore;
+};
+
+struct program_s {
+    struct instr_s *code;
+    unsigned int len;
+    unsigned int cap;
+    unsigned int refs;  // la tabla de funciones y las llamadas en curso
+};
+
+static struct program_s *program_new(void) {
+    struct program_s *prog = calloc(1, sizeof(struct program_s));
+    prog->refs = 1;
+    return prog;
+}
+
+/* Grupos { ...; } y ( ... ): cada uno se compila aparte y en su comando lo
+ * reemplaza una palabra GROUP_MARK N, así el grupo entra en un pipeline como
+ * cualquier comando */
+
+#define GROUP_MARK '\x02'
+
+struct group_s {
+    struct program_s *body; // NULL: lugar libre
+    bool subshell;          // ( ... ): corre siempre en un proceso aparte
+    bool claimed;           // ya es de la instrucción del comando que lo usa
+};
+
+static struct group_s *groups = NULL;
+static unsigned int groups_len = 0;
+
+static void program_release(struct program_s *prog);
+
+static unsigned int group_add(struct program_s *body, bool subshell) {
+    unsigned int id = 0;
+    while (id < groups_len && groups[id].body != NULL) {
+        id++;
+    }
+    if (id == groups_len) {
+        groups = realloc(groups, (groups_len + 1) * sizeof(struct group_s));
+        groups_len++;
+    }
+    groups[id] = (struct group_s){body, subshell, false};
+    return id;
+}
+
+static void group_release(unsigned int id) {
+    program_release(groups[id].body);
+    groups[id].body = NULL;
+}
+
+static struct group_s *group_of(scommand cmd) { // el grupo que ocupa el comando, o NULL
+    if (scommand_is_empty(cmd) || scommand_front(cmd)[0] != GROUP_MARK) {
+        return NULL;
+    }
+    unsigned long id = strtoul(scommand_front(cmd) + 1, NULL, 10);
+    return id < groups_len && groups[id].body != NULL ? &groups[id] : NULL;
+}
+
+static void program_release(struct program_s *prog) {
+    if (prog == NULL || --prog->refs > 0) {
+        return;
+    }
+    for (unsigned int i = 0; i < prog->len; i++) {
+        struct instr_s *in = &prog->code[i];
+        if (in->pipe != NULL) {
+            pipeline_destroy(in->pipe);
+        }
+        for (unsigned int g = 0; g < in->ngroups; g++) {
+            group_release(in->groups[g]);
+        }
+        free(in->groups);
+        if (in->words != NULL) {
+            scommand_destroy(in->words);
+        }
+        free(in->name);
+        program_release(in->body);
+    }
+    free(prog->code);
+    free(prog);
+}
+
+static unsigned int emit(struct program_s *prog, op_t op) {
+    if (prog->len == prog->cap) {
+        prog->cap = prog->cap == 0 ? 16 : 2 * prog->cap;
+        prog->code = realloc(prog->code, prog->cap * sizeof(struct instr_s));
+    }
+    prog->code[prog->len] = (struct instr_s){.op = op};
+    return prog->len++;
+}
+
+/* Compilador */
+
+struct loop_s {
+    unsigned int next;      // adónde salta continue
+    bool is_for;            // tiene un iterador apilado
+    unsigned int *breaks;   // saltos de break, a completar al terminar el ciclo
+    unsigned int nbreaks;
+};
+
+struct compiler_s {
+    struct items_s items;
+    unsigned int pos;
+    struct loop_s *loops;   // ciclos abiertos del programa que se compila
+    unsigned int nloops;
+    unsigned int *made;     // grupos sacados del texto, a liberar si ningún comando los usa
+    unsigned int nmade;
+};
+
+static const struct item_s *peek(struct compiler_s *c) {
+    return c->pos < c->items.len ? &c->items.v[c->pos] : NULL;
+}
+
+static bool expect(struct compiler_s *c, const char *word) {
+    const struct item_s *item = peek(c);
+    if (item == NULL || !is_word(item, word)) {
+        fprintf(stderr, "Error de sintaxis: se esperaba '%s'.\n", word);
+        return false;
+    }
+    c->pos++;
+    return true;
+}
+
+static scommand split_words(const char *text) { // palabras sin expandir
+    scommand words = scommand_new();
+    char *word;
+    while ((word = split_word(text, &text)) != NULL) {
+        scommand_push_back(words, word);
+    }
+    return words;
+}
+
+static bool loop_count(struct compiler_s *c, const char *keyword, const char *arg, unsigned int *n) {
+    // N de break N / continue N, acotado a los ciclos abiertos
+    if (c->nloops == 0) {
+        fprintf(stderr, "%s: sólo tiene sentido dentro de un ciclo\n", keyword);
+        return false;
+    }
+    char *end;
+    long value = *arg != '\0' ? strtol(arg, &end, 10) : 1;
+    if ((*arg != '\0' && *end != '\0') || value < 1) {
+        fprintf(stderr, "%s: %s: se esperaba un número positivo\n", keyword, arg);
+        return false;
+    }
+    *n = value > (long)c->nloops ? c->nloops : (unsigned int)value;
+    return true;
+}
+
+static bool compile_list(struct compiler_s *c, struct program_s *prog, const char *const *stops);
+
+static void claim_groups(struct instr_s *in, const char *text) {
+    // los grupos que aparecen en el comando pasan a ser de su instrucción
+    for (const char *mark = strchr(text, GROUP_MARK); mark != NULL; mark = strchr(mark + 1, GROUP_MARK)) {
+        unsigned long id = strtoul(mark + 1, NULL, 10);
+        if (id < groups_len && groups[id].body != NULL && !groups[id].claimed) {
+            groups[id].claimed = true;
+            in->groups = realloc(in->groups, (in->ngroups + 1) * sizeof(unsigned int));
+            in->groups[in->ngroups++] = (unsigned int)id;
+        }
+    }
+}
+
+static bool is_boundary(char c) { // termina una palabra
+    return c == '\0' || strchr(" \t\n;|&<>()", c) != NULL;
+}
+
+static bool command_position(const char *text, size_t i) {
+    // text[i] empieza un comando: está al principio, después de ; | & ( o un
+    // salto de línea, o de una palabra clave que abre un bloque (then, do, ...)
+    while (i > 0 && (text[i - 1] == ' ' || text[i - 1] == '\t')) {
+        i--;
+    }
+    if (i == 0 || strchr(";\n|&(", text[i - 1]) != NULL) {
+        return true;
+    }
+    size_t end = i;
+    while (i > 0 && !is_boundary(text[i - 1])) {
+        i--;
+    }
+    char word[8];
+    if (end - i >= sizeof(word)) {
+        return false;
+    }
+    memcpy(word, text + i, end - i);
+    word[end - i] = '\0';
+    return one_of(word, opening) && command_position(text, i);
+}
+
+static bool after_function_header(const char *text, size_t i) {
+    // el { de la línea siguiente a NOMBRE() o function NOMBRE abre su cuerpo
+    while (i > 0 && isspace((unsigned char)text[i - 1])) {
+        i--;
+    }
+    size_t end = i;
+    while (i > 0 && text[i - 1] != '\n' && text[i - 1] != ';') {
+        i--;
+    }
+    i += strspn(text + i, " \t");
+    return (end >= i + 2 && !strncmp(text + end - 2, "()", 2)) ||
+           (!strncmp(text + i, "function", 8) && isspace((unsigned char)text[i + 8]));
+}
+
+static size_t skip_quoted(const char *text, size_t k) {
+    // text[k] abre comillas: devuelve la posición de la que las cierra
+    char quote = text[k];
+    for (k++; text[k] != '\0' && text[k] != quote; k++) {
+        if (text[k] == '\\' && quote == '"' && text[k + 1] != '\0') {
+            k++;
+        }
+    }
+    return text[k] == '\0' ? k - 1 : k;
+}
+
+static size_t group_end(const char *text, size_t i) {
+    // posición del } o ) que cierra el grupo que abre text[i]; 0 si no cierra.
+    // Las llaves cuentan sólo como palabras sueltas: ${x} o {a, b} no
+    char open = text[i];
+    char close = open == '{' ? '}' : ')';
+    int depth = 0;
+    for (size_t k = i; text[k] != '\0'; k++) {
+        if (text[k] == '\\' && text[k + 1] != '\0') {
+            k++;
+            continue;
+        }
+        if (text[k] == '\'' || text[k] == '"') {
+            k = skip_quoted(text, k);
+            continue;
+        }
+        bool word = open == '(' || ((k == 0 || is_boundary(text[k - 1])) && is_boundary(text[k + 1]));
+        if (text[k] == open && word) {
+            depth++;
+        } else if (text[k] == close && word && --depth == 0) {
+            return k;
+        }
+    }
+    return 0;
+}
+
+static bool find_group(const char *text, size_t from, size_t *open, size_t *close) {
+    // busca desde `from' el próximo grupo que abre donde empieza un comando;
+    // si no se cierra, *close queda en 0
+    for (size_t i = from; text[i] != '\0'; i++) {
+        char c = text[i];
+        if (c == '\\' && text[i + 1] != '\0') {
+            i++;
+        } else if (c == '\'' || c == '"') {
+            i = skip_quoted(text, i);
+        } else if (c == '#' && (i == 0 || isspace((unsigned char)text[i - 1]))) {
+            i += strcspn(text + i, "\n") - 1; // comentario
+        } else if ((c == '(' || (c == '{' && isspace((unsigned char)text[i + 1]))) &&
+                   command_position(text, i) && !(c == '{' && after_function_header(text, i))) {
+            *open = i;
+            *close = group_end(text, i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static struct program_s *compile_text(const char *text);
+
+static char *skip_groups(const char *text, bool *unclosed) {
+    // `text' con cada grupo reemplazado por un comando vacío, sin compilarlo;
+    // en *unclosed queda si alguno no se cierra
+    char *out = strdup(text);
+    size_t pos = 0;
+    size_t open, close;
+    *unclosed = false;
+    while (find_group(out, pos, &open, &close)) {
+        if (close == 0) {
+            *unclosed = true;
+            break;
+        }
+        memmove(out + open + 1, out + close + 1, strlen(out + close + 1) + 1);
+        out[open] = ':';
+        pos = open + 1;
+    }
+    return out;
+}
+
+static char *extract_groups(struct compiler_s *c, const char *text, bool *ok) {
+    // compila cada grupo de `text' y devuelve el texto con cada uno
+    // reemplazado por su palabra GROUP_MARK N
+    char *out = malloc(strlen(text) + 1);
+    size_t len = 0;
+    size_t pos = 0;
+    size_t open, close;
+    while (*ok && find_group(text, pos, &open, &close)) {
+        if (close == 0) {
+            fprintf(stderr, "Error de sintaxis: falta '%c'.\n", text[open] == '(' ? ')' : '}');
+            *ok = false;
+            break;
+        }
+        char *inner = strndup(text + open + 1, close - open - 1);
+        struct program_s *body = compile_text(inner);
+        free(inner);
+        if (body == NULL) {
+            *ok = false;
+            break;
+        }
+        unsigned int id = group_add(body, text[open] == '(');
+        c->made = realloc(c->made, (c->nmade + 1) * sizeof(unsigned int));
+        c->made[c->nmade++] = id;
+        char mark[16];
+        int mark_len = snprintf(mark, sizeof(mark), " %c%u ", GROUP_MARK, id);
+        out = realloc(out, len + (open - pos) + (size_t)mark_len + strlen(text + close) + 1);
+        memcpy(out + len, text + pos, open - pos);
+        len += open - pos;
+        memcpy(out + len, mark, (size_t)mark_len);
+        len += (size_t)mark_len;
+        pos = close + 1;
+    }
+    strcpy(out + len, text + pos);
+    return out;
+}
+
+static bool compile_if(struct compiler_s *c, struct program_s *prog) {
+    static const char *const then_stop[] = {"then", NULL};
+    static const char *const branch_stop[] = {"elif", "else", "fi", NULL};
+    static const char *const fi_stop[] = {"fi", NULL};
+    unsigned int *ends = NULL; // saltos al final de cada rama, a completar en el fi
+    unsigned int nends = 0;
+    unsigned int cap = 0;
+    bool ok = true;
+
+    c->pos++; // if
+    bool more = true;
+    while (ok && more) { // if/elif CONDICIÓN then CUERPO
+        ok = compile_list(c, prog, then_stop) && expect(c, "then");
+        if (!ok) {
+            break;
+        }
+        unsigned int skip = emit(prog, OP_JUMP_IF);
+        prog->code[skip].when = false;
+        ok = compile_list(c, prog, branch_stop);
+        if (!ok) {
+            break;
+        }
+        if (nends == cap) {
+            cap = cap == 0 ? 4 : 2 * cap;
+            ends = realloc(ends, cap * sizeof(unsigned int));
+        }
+        ends[nends++] = emit(prog, OP_JUMP);
+        prog->code[skip].target = prog->len;
+        more = peek(c) != NULL && is_word(peek(c), "elif");
+        if (more) {
+            c->pos++;
+        }
+    }
+
+    if (ok && peek(c) != NULL && is_word(peek(c), "else")) {
+        c->pos++;
+        ok = compile_list(c, prog, fi_stop);
+    } else if (ok) {
+        emit(prog, OP_TRUE); // sin rama que ejecutar, el if termina bien
+    }
+    ok = ok && expect(c, "fi");
+    for (unsigned int i = 0; ok && i < nends; i++) {
+        prog->code[ends[i]].target = prog->len;
+    }
+    free(ends);
+    return ok;
+}
+
+static bool compile_body(struct compiler_s *c, struct program_s *prog, unsigned int next, bool is_for,
+                         unsigned int *end) {
+    // do CUERPO done de un ciclo que vuelve a `next'; deja en *end el final
+    // del ciclo, adonde saltan los break
+    static const char *const done_stop[] = {"done", NULL};
+    if (!expect(c, "do")) {
+        return false;
+    }
+    c->loops = realloc(c->loops, (c->nloops + 1) * sizeof(struct loop_s));
+    c->loops[c->nloops++] = (struct loop_s){next, is_for, NULL, 0};
+    bool ok = compile_list(c, prog, done_stop) && expect(c, "done");
+    struct loop_s loop = c->loops[--c->nloops];
+    if (ok) {
+        unsigned int jump = emit(prog, OP_JUMP);
+        prog->code[jump].target = next;
+        *end = prog->len;
+        for (unsigned int i = 0; i < loop.nbreaks; i++) {
+            prog->code[loop.breaks[i]].target = *end;
+        }
+    }
+    free(loop.breaks);
+    return ok;
+}
+
+static bool compile_while(struct compiler_s *c, struct program_s *prog, bool until) {
+    static const char *const do_stop[] = {"do", NULL};
+    c->pos++; // while / until
+    emit(prog, OP_TRUE); // si el cuerpo no se ejecuta, el ciclo termina bien
+    unsigned int next = emit(prog, OP_SAVE);
+    if (!compile_list(c, prog, do_stop)) {
+        return false;
+    }
+    unsigned int exit = emit(prog, OP_JUMP_IF);
+    prog->code[exit].when = until;
+    prog->code[exit].restore = true;
+    unsigned int end;
+    if (!compile_body(c, prog, next, false, &end)) {
+        return false;
+    }
+    prog->code[exit].target = end;
+    return true;
+}
+
+static bool compile_for(struct compiler_s *c, struct program_s *prog) {
+    const char *rest;
+    char *name = split_word(c->items.v[c->pos].text, &rest);
+    c->pos++;
+    if (name == NULL || !vars_valid_name(name, strlen(name))) {
+        fprintf(stderr, "for: '%s': no es un identificador válido\n", name != NULL ? name : "");
+        free(name);
+        return false;
+    }
+    const char *list = "\"$@\""; // sin `in', recorre los argumentos
+    if (*rest != '\0') {
+        const char *after;
+        char *in = split_word(rest, &after);
+        bool ok = !strcmp(in, "in");
+        free(in);
+        if (!ok) {
+            fprintf(stderr, "Error de sintaxis: se esperaba 'in'.\n");
+            free(name);
+            return false;
+        }
+        list = after;
+    }
+    unsigned int start = emit(prog, OP_FOR);
+    prog->code[start].words = split_words(list);
+    unsigned int next = emit(prog, OP_NEXT);
+    prog->code[next].name = name;
+    unsigned int end;
+    if (!compile_body(c, prog, next, true, &end)) {
+        return false;
+    }
+    prog->code[next].target = end;
+    return true;
+}
+
+static const char *peek_closing(struct compiler_s *c, int depth) {
+    // las redirecciones del fi, done o } que cierra el bloque abierto (con
+    // `depth' 1 si ya se pasó su palabra de apertura); NULL si no tiene
+    static const char *const openers[] = {"if", "while", "until", "for", "function", NULL};
+    for (unsigned int i = c->pos; i < c->items.len; i++) {
+        const struct item_s *item = &c->items.v[i];
+        if (item->word != NULL && one_of(item->word, openers)) {
+            depth++;
+        } else if (item->word != NULL && one_of(item->word, closing) && --depth == 0) {
+            return item->text;
+        }
+    }
+    return NULL;
+}
+
+static bool emit_group(struct program_s *prog, struct program_s *block, const char *redirs) {
+    // agrega a `prog' un comando que corre `block' como un grupo { ...; }
+    // con las redirecciones `redirs', que así se abren una sola vez
+    unsigned int id = group_add(block, false);
+    char *text = malloc(strlen(redirs) + 16);
+    sprintf(text, "%c%u %s", GROUP_MARK, id, redirs);
+    pipeline template = parse_template(text);
+    if (template == NULL) {
+        fprintf(stderr, "Error: redirección inválida: %s\n", redirs);
+        group_release(id);
+        free(text);
+        return false;
+    }
+    unsigned int run = emit(prog, OP_RUN);
+    prog->code[run].pipe = template;
+    claim_groups(&prog->code[run], text);
+    free(text);
+    return true;
+}
+
+static bool compile_compound(struct compiler_s *c, struct program_s *prog) { // if, while, until o for
+    const char *word = peek(c)->word;
+    if (!strcmp(word, "if")) {
+        return compile_if(c, prog);
+    }
+    if (!strcmp(word, "for")) {
+        return compile_for(c, prog);
+    }
+    return compile_while(c, prog, !strcmp(word, "until"));
+}
+
+static bool compile_redirected(struct compiler_s *c, struct program_s *prog, const char *redirs) {
+    // `while read l; do ...; done < archivo': el bloque se compila aparte y
+    // corre como un grupo con esas redirecciones. Como en un grupo, break y
+    // continue de adentro no llegan a los ciclos de afuera
+    struct loop_s *loops = c->loops;
+    unsigned int nloops = c->nloops;
+    c->loops = NULL;
+    c->nloops = 0;
+    struct program_s *block = program_new();
+    bool ok = compile_compound(c, block);
+    free(c->loops);
+    c->loops = loops;
+    c->nloops = nloops;
+    if (!ok) {
+        program_release(block);
+        return false;
+    }
+    return emit_group(prog, block, redirs);
+}
+
+static bool compile_function(struct compiler_s *c, struct program_s *prog) {
+    static const char *const close_stop[] = {"}", NULL};
+    const char *name = c->items.v[c->pos].text;
+    c->pos++;
+    if (!vars_valid_name(name, strlen(name))) {
+        fprintf(stderr, "function: '%s': no es un nombre válido\n", name);
+        return false;
+    }
+    if (!expect(c, "{")) {
+        return false;
+    }
+    struct loop_s *loops = c->loops; // los break del cuerpo no salen de la función
+    unsigned int nloops = c->nloops;
+    c->loops = NULL;
+    c->nloops = 0;
+    struct program_s *body = program_new();
+    const char *redirs = peek_closing(c, 1);
+    bool ok = compile_list(c, body, close_stop) && expect(c, "}");
+    free(c->loops);
+    c->loops = loops;
+    c->nloops = nloops;
+    if (ok && redirs != NULL) { // NOMBRE() { ...; } > archivo: valen en cada llamada
+        struct program_s *call = program_new();
+        ok = emit_group(call, body, redirs);
+        body = call;
+    }
+    if (!ok) {
+        program_release(body);
+        return false;
+    }
+    unsigned int define = emit(prog, OP_DEFINE);
+    prog->code[define].name = strdup(name);
+    prog->code[define].body = body;
+    return true;
+}
+
+static bool compile_jump(struct compiler_s *c, struct program_s *prog, bool is_break) {
+    // break N sale de N ciclos; continue N sale de N-1 y vuelve a empezar el
+    // N-ésimo. Los for de los que se sale dejan su iterador
+    const struct item_s *item = &c->items.v[c->pos++];
+    unsigned int n;
+    if (!loop_count(c, item->word, item->text, &n)) {
+        return false;
+    }
+    struct loop_s *target = &c->loops[c->nloops - n];
+    unsigned int jump = emit(prog, OP_JUMP);
+    for (unsigned int i = c->nloops - n; i < c->nloops; i++) {
+        if (c->loops[i].is_for && (is_break || &c->loops[i] != target)) {
+            prog->code[jump].pops++;
+        }
+    }
+    if (is_break) {
+        target->breaks = realloc(target->breaks, (target->nbreaks + 1) * sizeof(unsigned int));
+        target->breaks[target->nbreaks++] = jump;
+    } else {
+        prog->code[jump].target = target->next;
+    }
+    return true;
+}
+
+static bool compile_list(struct compiler_s *c, struct program_s *prog, const char *const *stops) {
+    // compila comandos hasta una de las palabras de `stops' (que queda sin
+    // consumir) o el final del texto
+    const struct item_s *item;
+    while ((item = peek(c)) != NULL && (item->word == NULL || stops == NULL || !one_of(item->word, stops))) {
+        bool ok = true;
+        if (item->word == NULL) {
+            pipeline template = parse_template(item->text);
+            if (template == NULL) {
+                fprintf(stderr, "Error: comando inválido o error de sintaxis: %s\n", item->text);
+                return false;
+            }
+            unsigned int run = emit(prog, OP_RUN);
+            prog->code[run].pipe = template;
+            claim_groups(&prog->code[run], item->text);
+            c->pos++;
+        } else if (!strcmp(item->word, "if") || !strcmp(item->word, "while") || !strcmp(item->word, "until") ||
+                   !strcmp(item->word, "for")) {
+            const char *redirs = peek_closing(c, 0);
+            ok = redirs != NULL ? compile_redirected(c, prog, redirs) : compile_compound(c, prog);
+        } else if (!strcmp(item->word, "function")) {
+            ok = compile_function(c, prog);
+        } else if (!strcmp(item->word, "break") || !strcmp(item->word, "continue")) {
+            ok = compile_jump(c, prog, !strcmp(item->word, "break"));
+        } else if (!strcmp(item->word, "return")) {
+            unsigned int ret = emit(prog, OP_RETURN);
+            if (item->text[0] != '\0') {
+                prog->code[ret].words = split_words(item->text);
+            }
+            c->pos++;
+        } else {
+            fprintf(stderr, "Error de sintaxis: '%s' inesperado.\n", item->word);
+            return false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Intérprete */
+
+struct function_s {
+    char *name;
+    struct program_s *body;
+};
+
+static struct function_s *functions = NULL;
+static unsigned int functions_len = 0;
+static unsigned int calls = 0;          // llamadas en curso
+static bool interrupted = false;        // un comando terminó por Ctrl-C: se corta todo
+static bool returning = false;          // se ejecutó return: se sale hasta la función
+
+static struct function_s *function_find(const char *name) {
+    for (unsigned int i = 0; i < functions_len; i++) {
+        if (!strcmp(functions[i].name, name)) {
+            return &functions[i];
+        }
+    }
+    return NULL;
+}
+
+static void function_define(const char *name, struct program_s *body) {
+    struct function_s *fn = function_find(name);
+    if (fn == NULL) {
+        functions = realloc(functions, (functions_len + 1) * sizeof(struct function_s));
+        fn = &functions[functions_len++];
+        fn->name = strdup(name);
+    } else {
+        program_release(fn->body); // si se está ejecutando, la llamada conserva el suyo
+    }
+    body->refs++;
+    fn->body = body;
+}
+
+struct iter_s {
+    scommand words;
+    unsigned int next;
+};
+
+static int exec_program(struct program_s *prog) {
+    struct iter_s *iters = NULL;
+    unsigned int niters = 0;
+    int status = vars_get_status();
+    int saved = status;
+
+    for (unsigned int pc = 0; pc < prog->len && !returning && !interrupted;) {
+        struct instr_s *in = &prog->code[pc++];
+        switch (in->op) {
+        case OP_RUN:
+            status = flow_run_pipeline(parse_instantiate(in->pipe));
+            interrupted = interrupted || status == 128 + SIGINT;
+            break;
+        case OP_TRUE:
+            status = 0;
+            vars_set_status(status);
+            break;
+        case OP_SAVE:
+            saved = status;
+            break;
+        case OP_JUMP:
+            for (unsigned int i = 0; i < in->pops; i++) {
+                scommand_destroy(iters[--niters].words);
+            }
+            pc = in->target;
+            break;
+        case OP_JUMP_IF:
+            if ((status == 0) == in->when) {
+                if (in->restore) {
+                    status = saved;
+                    vars_set_status(status);
+                }
+                pc = in->target;
+            }
+            break;
+        case OP_FOR:
+            iters = realloc(iters, (niters + 1) * sizeof(struct iter_s));
+            iters[niters].words = scommand_copy(in->words);
+            iters[niters].next = 0;
+            parse_expand_words(iters[niters].words);
+            pathexp_cache_reset();
+            niters++;
+            break;
+        case OP_NEXT: {
+            struct iter_s *it = &iters[niters - 1];
+            if (it->next < scommand_length(it->words)) {
+                vars_set(in->name, scommand_nth(it->words, it->next++));
+            } else {
+                scommand_destroy(iters[--niters].words);
+                pc = in->target;
+            }
+            break;
+        }
+        case OP_DEFINE:
+            function_define(in->name, in->body);
+            status = 0;
+            vars_set_status(status);
+            break;
+        case OP_RETURN:
+            if (in->words != NULL) {
+                scommand value = scommand_copy(in->words);
+                parse_expand_words(value);
+                status = scommand_is_empty(value) ? status : atoi(scommand_front(value)) & 0xff;
+                scommand_destroy(value);
+                vars_set_status(status);
+            }
+            returning = true;
+            break;
+        }
+    }
+    while (niters > 0) {
+        scommand_destroy(iters[--niters].words);
+    }
+    free(iters);
+    return status;
+}
+
+static int function_call(struct function_s *fn, scommand cmd) {
+    if (calls == 0) {
+        interrupted = false; // llamada desde una línea simple
+    }
+    if (calls == FLOW_MAX_CALLS) {
+        fprintf(stderr, "%s: demasiadas llamadas anidadas\n", fn->name);
+        return EXIT_FAILURE;
+    }
+    unsigned int argc = scommand_length(cmd);
+    char **args = malloc(argc * sizeof(char *)); // $1 ... $n, terminado en NULL
+    for (unsigned int i = 1; i < argc; i++) {
+        args[i - 1] = strdup(scommand_nth(cmd, i));
+    }
+    args[argc - 1] = NULL;
+
+    struct program_s *body = fn->body; // la función puede redefinirse mientras corre
+    body->refs++;
+    char **outer = vars_swap_args(args);
+    calls++;
+    int status = exec_program(body);
+    returning = false;
+    calls--;
+    vars_set_args(outer); // libera los de la llamada, o los que dejó mapfile
+    program_release(body);
+    return status;
+}
+
+static bool group_words_ok(scommand cmd) { // { ...; } sólo admite redirecciones después
+    if (scommand_length(cmd) > 1) {
+        fprintf(stderr, "%s: palabras de más después de un grupo\n", scommand_nth(cmd, 1));
+        return false;
+    }
+    return true;
+}
+
+static int group_run_here(struct group_s *group, scommand cmd) {
+    // un grupo { ...; } solo y esperado corre en el shell: sus redirecciones
+    // se abren una vez y valen para todos sus comandos
+    int saved[REDIR_FDS];
+    if (!group_words_ok(cmd)) {
+        return 2;
+    }
+    if (!redir_push(cmd, saved)) {
+        return EXIT_FAILURE;
+    }
+    struct program_s *body = group->body;
+    body->refs++;
+    int status = exec_program(body);
+    program_release(body);
+    redir_pop(saved);
+    return status;
+}
+
+bool flow_is_group(scommand cmd) {
+    assert(cmd != NULL);
+    return group_of(cmd) != NULL;
+}
+
+void flow_group_exec(scommand cmd) {
+    assert(flow_is_group(cmd));
+    option_set(OPT_ZYGOTE, false); // el pool es del shell, no de este proceso
+    __fpurge(stdin); // lo que el shell ya leyó del script es suyo: al terminar no se devuelve
+    int status = 2;
+    if (group_words_ok(cmd)) {
+        status = exec_program(group_of(cmd)->body);
+    }
+    fflush(stdout);
+    _exit(status);
+}
+
+bool flow_is_function(scommand cmd) {
+    assert(cmd != NULL);
+    return !scommand_is_empty(cmd) && function_find(scommand_front(cmd)) != NULL;
+}
+
+void flow_function_exec(scommand cmd) {
+    assert(flow_is_function(cmd));
+    option_set(OPT_ZYGOTE, false);
+    __fpurge(stdin);
+    int status = function_call(function_find(scommand_front(cmd)), cmd);
+    fflush(stdout);
+    _exit(status);
+}
+
+int flow_run_pipeline(pipeline pipe) {
+    assert(pipe != NULL);
+    int status;
+    alloc_phase_t phase = alloc_phase(ALLOC_BUILD);
+    plan_pipeline(pipe); // simplifica el pipeline antes de ejecutarlo
+    if (option_get(OPT_TRACE)) { // set -x: muestra lo que se va a ejecutar
+        char *str = pipeline_to_string(pipe);
+        fprintf(stderr, "+ %s\n", str);
+        free(str);
+    }
+    audit_entry audit = audit_begin(pipe); // antes: ejecutarlo puede modificar el pipeline
+    alloc_phase(ALLOC_EXECUTE);
+    // con `timeout' nada corre en el shell: el plazo se cumple sobre un proceso
+    bool here = pipeline_length(pipe) == 1 && pipeline_fanout_count(pipe) == 0 && pipeline_get_wait(pipe) &&
+                pipeline_get_timeout(pipe) == 0;
+    struct function_s *fn = NULL;
+    if (here) {
+        fn = function_find(scommand_front(pipeline_front(pipe)));
+    }
+    struct group_s *group = NULL;
+    if (here) {
+        group = group_of(pipeline_front(pipe));
+    }
+    if (fn != NULL) {
+        status = function_call(fn, pipeline_front(pipe));
+    } else if (group != NULL && !group->subshell) {
+        status = group_run_here(group, pipeline_front(pipe));
+    } else {
+        bool alone = builtin_alone(pipe) && pipeline_get_timeout(pipe) == 0; // un único comando interno
+        metrics_count(alone ? METRIC_BUILTIN : METRIC_EXTERNAL);
+        if (alone) {
+            status = builtin_run(pipeline_front(pipe)); // ejecutamos el comando interno
+        } else {
+            status = execute_pipeline(pipe); // si no es un comando interno, ejecutamos el pipeline normalmente
+        }
+    }
+    audit_end(audit, status);
+    pipeline_destroy(pipe);
+    pathexp_cache_reset(); // los listados de directorios valen sólo para este comando
+    alloc_phase(phase);
+    vars_set_status(status); // queda en $?
+    return status;
+}
+
+bool flow_is_compound(const char *text) {
+    assert(text != NULL);
+    if (strpbrk(text, ";\n(&") == NULL) { // lo más común: un solo comando sin palabras clave
+        const char *rest;
+        char *word = split_word(text, &rest);
+        bool plain = word == NULL || (!one_of(word, opening) && !one_of(word, closing) &&
+                                      !one_of(word, with_args) && strcmp(word, "function") != 0);
+        free(word);
+        if (plain) {
+            return false;
+        }
+    }
+    size_t open, close;
+    if (find_group(text, 0, &open, &close)) {
+        return true;
+    }
+    struct items_s items;
+    bool ok = tokenize(text, &items, false); // los errores los informa flow_run()
+    bool compound = !ok || items.len > 1 || (items.len == 1 && items.v[0].word != NULL);
+    items_free(&items);
+    return compound;
+}
+
+bool flow_incomplete(const char *text) {
+    assert(text != NULL);
+    struct items_s items = {NULL, 0, 0};
+    int depth = 0;
+    bool unclosed;
+    char *plain = skip_groups(text, &unclosed);
+    if (!unclosed && tokenize(plain, &items, false)) {
+        for (unsigned int i = 0; i < items.len; i++) {
+            const char *word = items.v[i].word;
+            if (word != NULL && (!strcmp(word, "if") || !strcmp(word, "while") || !strcmp(word, "until") ||
+                                 !strcmp(word, "for") || !strcmp(word, "{"))) {
+                depth++;
+            } else if (word != NULL && !strcmp(word, "function")) { // abre con su `{'
+                depth++;
+                if (i + 1 < items.len && is_word(&items.v[i + 1], "{")) {
+                    i++;
+                }
+            } else if (word != NULL && one_of(word, closing)) {
+                depth--;
+            }
+        }
+    }
+    items_free(&items);
+    free(plain);
+    return unclosed || depth > 0;
+}
+
+static struct program_s *compile_text(const char *text) {
+    // compila `text' (y sus grupos); NULL si está mal formado
+    struct compiler_s c = {{NULL, 0, 0}, 0, NULL, 0, NULL, 0};
+    struct program_s *prog = program_new();
+    bool ok = true;
+    char *plain = extract_groups(&c, text, &ok);
+    ok = ok && tokenize(plain, &c.items, true) && compile_list(&c, prog, NULL);
+    for (unsigned int i = 0; i < c.nmade; i++) {
+        if (!groups[c.made[i]].claimed) { // p.ej. quedó en un lugar que no es un comando
+            group_release(c.made[i]);
+        }
+    }
+    free(c.made);
+    free(c.loops);
+    items_free(&c.items);
+    free(plain);
+    if (!ok) {
+        program_release(prog);
+        return NULL;
+    }
+    return prog;
+}
+
+int flow_run(const char *text) {
+    assert(text != NULL);
+    struct program_s *prog = compile_text(text);
+    int status = 2;
+    if (prog != NULL) {
+        interrupted = false;
+        status = exec_program(prog);
+        returning = false; // return fuera de una función sólo corta el texto
+        program_release(prog);
+    }
+    vars_set_status(status);
+    return status;
+}
@@ -0,0 +1,103 @@
+/* Estructuras de control, funciones y listas de comandos.
+ *
+ * Un bloque se compila una sola vez a una secuencia de instrucciones que
+ * ejecuta un intérprete chico sobre execute_pipeline(). Cada comando queda
+ * guardado como un pipeline de parse_template() y en cada ejecución sólo
+ * se copia y se expande: el cuerpo de un ciclo no se vuelve a parsear en
+ * cada vuelta. Las funciones quedan compiladas hasta que se redefinen.
+ *
+ * La sintaxis es la de sh, con un comando por línea o separados por `;':
+ *
+ *   if CMD; then ...; elif CMD; then ...; else ...; fi
+ *   while CMD; do ...; done          until CMD; do ...; done
+ *   for NOMBRE in PALABRAS; do ...; done
+ *   NOMBRE() { ...; }                function NOMBRE { ...; }
+ *   break [N]   continue [N]   return [N]
+ *   { ...; }                         ( ... )
+ *
+ * Un grupo { ...; } corre en el shell y ( ... ) en un proceso aparte; los
+ * dos son un comando más dentro de un pipeline (`{ a; b; } | c') y sus
+ * redirecciones se aplican una sola vez al grupo entero. Un grupo que no
+ * corre solo (en un pipeline, o en segundo plano) va siempre en un proceso
+ * hijo, como ( ... ).
+ *
+ * Después de fi, done o } pueden ir redirecciones, que valen para el bloque
+ * entero (`while read l; do ...; done < archivo'). Ese bloque corre como un
+ * grupo, así que sus break y continue no salen a los ciclos de afuera.
+ *
+ * Dentro de una función, $1, $2, ..., $# y $@ son sus argumentos.
+ */
+
+#ifndef _FLOW_H_
+#define _FLOW_H_
+
+#include <stdbool.h>
+#include "command.h"
+
+bool flow_is_compound(const char *text);
+/*
+ * Indica si `text' tiene que ejecutarse con flow_run(): empieza con una
+ * palabra clave o una definición de función, o tiene varios comandos.
+ *
+ * REQUIRES: text != NULL
+ */
+
+bool flow_incomplete(const char *text);
+/*
+ * Indica si en `text' queda abierto algún bloque (falta un fi, done o }),
+ * para seguir leyendo líneas antes de ejecutarlo.
+ *
+ * REQUIRES: text != NULL
+ */
+
+int flow_run(const char *text);
+/*
+ * Compila y ejecuta `text'. Devuelve el estado del último comando
+ * ejecutado, que también queda en $?, o 2 si hay un error de sintaxis.
+ *
+ * REQUIRES: text != NULL
+ */
+
+int flow_run_pipeline(pipeline pipe);
+/*
+ * Ejecuta un pipeline ya expandido: lo simplifica, lo muestra si está
+ * activo `set -x' y lo corre como llamada a una función, comando interno o
+ * procesos. Destruye `pipe' y devuelve su estado, que también queda en $?.
+ *
+ * REQUIRES: pipe != NULL
+ */
+
+bool flow_is_group(scommand cmd);
+/*
+ * Indica si `cmd' es un grupo { ...; } o ( ... ) que ocupa un lugar de un
+ * pipeline, y que entonces hay que lanzar con flow_group_exec().
+ *
+ * REQUIRES: cmd != NULL
+ */
+
+void flow_group_exec(scommand cmd);
+/*
+ * En el proceso hijo, con la entrada, la salida y las redirecciones del
+ * grupo ya puestas: ejecuta sus comandos y termina el proceso con el
+ * estado del último.
+ *
+ * REQUIRES: flow_is_group(cmd)
+ */
+
+bool flow_is_function(scommand cmd);
+/*
+ * Indica si `cmd' llama a una función definida. Solo, sin plazo, corre en
+ * el shell; en un pipeline o con `timeout' se lanza con flow_function_exec().
+ *
+ * REQUIRES: cmd != NULL
+ */
+
+void flow_function_exec(scommand cmd);
+/*
+ * En el proceso hijo, con la entrada, la salida y las redirecciones ya
+ * puestas: llama a la función y termina el proceso con su estado.
+ *
+ * REQUIRES: flow_is_function(cmd)
+ */
+
+#endif
@@ -0,0 +1,143 @@
+#define _GNU_SOURCE     /* pipe2() */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "gzredir.h"
+#include "options.h"
+
+#define GZREDIR_BLOCK (128 * 1024)  // lo que se lee del pipe o del archivo de una vez
+
+struct gzredir_s {
+    gzFile file;
+    int pipe_fd;        // el extremo del hilo
+    bool output;
+    pthread_t thread;
+    char *path;         // para los mensajes
+    unsigned int refs;  // el hilo y el shell: el último que lo suelta lo libera
+};
+
+static void release(gzredir self) {
+    if (__atomic_sub_fetch(&self->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(self->path);
+        free(self);
+    }
+}
+
+bool gzredir_wanted(const char *path) {
+    assert(path != NULL);
+    size_t len = strlen(path);
+    return option_get(OPT_GZIP) && len > 3 && !strcmp(path + len - 3, ".gz");
+}
+
+static bool write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false; // EPIPE: el comando dejó de leer (head, ...)
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void *pump(void *arg) {
+    struct gzredir_s *self = arg;
+    char *block = malloc(GZREDIR_BLOCK);
+    if (self->output) { // pipe -> zlib -> archivo
+        ssize_t n;
+        while ((n = read(self->pipe_fd, block, GZREDIR_BLOCK)) != 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 || gzwrite(self->file, block, (unsigned int)n) != (int)n) {
+                fprintf(stderr, "%s: error al comprimir\n", self->path);
+                break;
+            }
+        }
+    } else { // archivo -> zlib -> pipe
+        int n;
+        while ((n = gzread(self->file, block, GZREDIR_BLOCK)) > 0 && write_all(self->pipe_fd, block, (size_t)n)) {
+        }
+        if (n < 0) {
+            int err;
+            fprintf(stderr, "%s: %s\n", self->path, gzerror(self->file, &err));
+        }
+    }
+    close(self->pipe_fd); // el comando ve el fin de su entrada
+    if (gzclose(self->file) != Z_OK && self->output) {
+        fprintf(stderr, "%s: error al cerrar el archivo\n", self->path);
+    }
+    free(block);
+    release(self);
+    return NULL;
+}
+
+gzredir gzredir_start(const char *path, bool output, int *fd) {
+    assert(path != NULL && fd != NULL);
+    int file_fd = open(path, output ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0666);
+    if (file_fd < 0) {
+        fprintf(stderr, "Error al abrir archivo '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    int ends[2];
+    if (pipe2(ends, O_CLOEXEC) < 0) {
+        perror("pipe");
+        close(file_fd);
+        return NULL;
+    }
+    gzFile file = gzdopen(file_fd, output ? "wb" : "rb"); // nivel 6, el de gzip
+    if (file == NULL) { // sin memoria para el estado de zlib; el descriptor sigue siendo nuestro
+        fprintf(stderr, "%s: no se pudo abrir con zlib\n", path);
+        close(file_fd);
+        close(ends[0]);
+        close(ends[1]);
+        return NULL;
+    }
+    gzredir self = malloc(sizeof(struct gzredir_s));
+    self->file = file;
+    self->output = output;
+    self->pipe_fd = output ? ends[0] : ends[1];
+    self->path = strdup(path);
+    self->refs = 2;
+    *fd = output ? ends[1] : ends[0];
+    gzbuffer(self->file, GZREDIR_BLOCK);
+
+    // el hilo no recibe señales: un SIGPIPE al escribir en el pipe queda en
+    // él (write devuelve EPIPE) y SIGINT, SIGCHLD, ... siguen siendo del shell
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&self->thread, NULL, pump, self);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(err));
+        gzclose(self->file);
+        close(ends[0]);
+        close(ends[1]);
+        free(self->path);
+        free(self);
+        return NULL;
+    }
+    return self;
+}
+
+void gzredir_finish(gzredir self, bool wait) {
+    assert(self != NULL);
+    if (wait) {
+        pthread_join(self->thread, NULL);
+    } else {
+        pthread_detach(self->thread);
+    }
+    release(self);
+}
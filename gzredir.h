@@ -0,0 +1,50 @@
+/* Redirecciones comprimidas: con `set -o gzip', `cmd > salida.gz' escribe
+ * el archivo comprimido y `cmd < entrada.gz' lee el descomprimido, sin
+ * lanzar gzip ni zcat.
+ *
+ * El comando recibe un pipe como entrada o salida, igual que en
+ * `cmd | gzip > salida.gz'; del otro lado no hay un proceso sino un hilo
+ * del shell que comprime (o descomprime) con zlib entre el pipe y el
+ * archivo. Al terminar el pipeline el shell espera a los hilos, así el
+ * archivo ya está completo para el comando siguiente. `< x.gz' también lee
+ * un archivo que no está comprimido, tal cual.
+ *
+ * Sólo `<' y `>' de un comando lanzado como proceso: los comandos internos
+ * (read, mapfile), `N>archivo' y las redirecciones de exec o de un grupo
+ * { ...; } que corre en el shell abren el archivo como siempre.
+ */
+
+#ifndef _GZREDIR_H_
+#define _GZREDIR_H_
+
+#include <stdbool.h>
+
+typedef struct gzredir_s *gzredir;
+
+bool gzredir_wanted(const char *path);
+/*
+ * Indica si una redirección a `path' se comprime: está activa la opción
+ * gzip y el nombre termina en ".gz".
+ *
+ * REQUIRES: path != NULL
+ */
+
+gzredir gzredir_start(const char *path, bool output, int *fd);
+/*
+ * Abre `path' y lanza el hilo que comprime hacia él (`output') o
+ * descomprime desde él. En *fd deja el extremo del pipe para el comando,
+ * con close-on-exec: el hijo lo pone como su 0 o 1 con dup2() y el shell
+ * lo cierra después del fork. Si algo falla lo informa y devuelve NULL.
+ *
+ * REQUIRES: path != NULL && fd != NULL
+ */
+
+void gzredir_finish(gzredir self, bool wait);
+/*
+ * Con `wait', espera a que el hilo termine (el comando cerró su extremo y
+ * el archivo quedó completo); si no, lo deja terminar solo. Libera `self'.
+ *
+ * REQUIRES: self != NULL
+ */
+
+#endif
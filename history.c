@@ -0,0 +1,270 @@
+#define _GNU_SOURCE     /* memmem(), mremap() */
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "history.h"
+
+#define SEARCH_WINDOW (64 * 1024)   // bloque en que se busca hacia atrás
+#define TAIL_CHECK 64               // bytes del final de lo indexado que se recuerdan
+
+static int hist_fd = -1;
+static char *hist_path = NULL;
+static dev_t hist_dev;              // archivo abierto: si `hist_path' ya es otro, se reabre
+static ino_t hist_ino;
+static char tail[TAIL_CHECK];       // copia del final de lo indexado, para notar si se reescribió
+static size_t tail_len = 0;
+static char *map = NULL;            // archivo mapeado
+static size_t map_len = 0;
+static size_t indexed_len = 0;      // hasta dónde están indexadas las líneas completas
+static size_t *offs = NULL;         // comienzo de cada entrada dentro del mapeo
+static size_t n_entries = 0;
+static size_t offs_cap = 0;
+
+static void index_range(size_t from, size_t to) { // indexa las líneas completas de [from, to)
+    const char *p = map + from;
+    const char *end = map + to;
+    const char *nl;
+    while (p < end && (nl = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        if (n_entries == offs_cap) {
+            offs_cap = offs_cap == 0 ? 4096 : 2 * offs_cap;
+            offs = realloc(offs, offs_cap * sizeof(size_t));
+        }
+        offs[n_entries++] = (size_t)(p - map);
+        p = nl + 1;
+    }
+    indexed_len = (size_t)(p - map);
+}
+
+static void forget_index(void) { // el archivo cambió por debajo: se vuelve a indexar desde cero
+    if (map != NULL) {
+        munmap(map, map_len);
+    }
+    map = NULL;
+    map_len = indexed_len = n_entries = tail_len = 0;
+}
+
+static void reopen_if_replaced(void) { // otro shell lo reemplazó con rename()
+    struct stat st;
+    if (stat(hist_path, &st) < 0 || (st.st_dev == hist_dev && st.st_ino == hist_ino)) {
+        return;
+    }
+    int fd = open(hist_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    close(hist_fd);
+    hist_fd = fd;
+    hist_dev = st.st_dev;
+    hist_ino = st.st_ino;
+    forget_index();
+}
+
+static void history_refresh(void) { // mapea e indexa lo que se agregó desde la última vez
+    struct stat st;
+    if (hist_fd < 0) {
+        return;
+    }
+    reopen_if_replaced();
+    if (fstat(hist_fd, &st) < 0) {
+        return;
+    }
+    // otro shell lo vació o lo recortó, aunque después haya vuelto a crecer:
+    // lo indexado ya no termina igual
+    if ((size_t)st.st_size < map_len || (size_t)st.st_size < indexed_len ||
+        (tail_len > 0 && memcmp(map + indexed_len - tail_len, tail, tail_len) != 0)) {
+        forget_index();
+    }
+    if ((size_t)st.st_size <= map_len) {
+        return;
+    }
+    size_t len = (size_t)st.st_size;
+    char *m = map == NULL ? mmap(NULL, len, PROT_READ, MAP_SHARED, hist_fd, 0)
+                          : mremap(map, map_len, len, MREMAP_MAYMOVE);
+    if (m == MAP_FAILED) {
+        return;
+    }
+    map = m;
+    map_len = len;
+    index_range(indexed_len, map_len);
+    tail_len = indexed_len < TAIL_CHECK ? indexed_len : TAIL_CHECK;
+    memcpy(tail, map + indexed_len - tail_len, tail_len);
+}
+
+static size_t entry_len(size_t n) { // largo de la entrada n, sin el '\n'
+    size_t end = n + 1 < n_entries ? offs[n + 1] : indexed_len;
+    return end - offs[n] - 1;
+}
+
+bool history_open(const char *path) {
+    assert(path != NULL);
+    history_close();
+    hist_fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    struct stat st;
+    if (hist_fd < 0 || fstat(hist_fd, &st) < 0) {
+        history_close();
+        return false;
+    }
+    hist_path = strdup(path);
+    hist_dev = st.st_dev;
+    hist_ino = st.st_ino;
+    history_refresh();
+    return true;
+}
+
+void history_close(void) {
+    if (map != NULL) {
+        munmap(map, map_len);
+    }
+    if (hist_fd >= 0) {
+        close(hist_fd);
+    }
+    free(offs);
+    free(hist_path);
+    hist_fd = -1;
+    hist_path = NULL;
+    map = NULL;
+    offs = NULL;
+    map_len = indexed_len = n_entries = offs_cap = tail_len = 0;
+}
+
+void history_add(const char *line) {
+    assert(line != NULL);
+    size_t len = strlen(line);
+    if (hist_fd < 0 || strspn(line, " \t") == len) {
+        return;
+    }
+    history_refresh();
+    if (n_entries > 0 && entry_len(n_entries - 1) == len &&
+        memcmp(map + offs[n_entries - 1], line, len) == 0) {
+        return; // igual a la anterior
+    }
+
+    char *rec = malloc(len + 1);
+    memcpy(rec, line, len);
+    rec[len] = '\n';
+    if (write(hist_fd, rec, len + 1) < 0) { // O_APPEND: la línea entera se agrega al final
+        perror("history");
+    }
+    free(rec);
+}
+
+size_t history_count(void) {
+    history_refresh();
+    return n_entries;
+}
+
+char *history_get(size_t n) {
+    history_refresh();
+    if (n >= n_entries) {
+        return NULL;
+    }
+    return strndup(map + offs[n], entry_len(n));
+}
+
+static size_t entry_at(size_t pos) { // entrada que contiene el byte `pos' (búsqueda binaria)
+    size_t lo = 0;
+    size_t hi = n_entries;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (offs[mid] <= pos) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static long search_prefix(const char *text, size_t tlen, size_t before) {
+    for (size_t n = before; n-- > 0;) {
+        if (entry_len(n) >= tlen && memcmp(map + offs[n], text, tlen) == 0) {
+            return (long)n;
+        }
+    }
+    return -1;
+}
+
+static long search_substring(const char *text, size_t tlen, size_t before) {
+    // recorre el mapeo hacia atrás en ventanas, buscando con memmem en cada una
+    size_t end = before < n_entries ? offs[before] : indexed_len;
+    while (end > 0) {
+        size_t start = end > SEARCH_WINDOW ? end - SEARCH_WINDOW : 0;
+        size_t len = end - start + (end < indexed_len ? tlen - 1 : 0); // las coincidencias pueden cruzar el borde
+        if (start + len > indexed_len) {
+            len = indexed_len - start;
+        }
+        const char *last = NULL;
+        const char *p = map + start;
+        const char *hit;
+        while ((hit = memmem(p, len - (size_t)(p - (map + start)), text, tlen)) != NULL &&
+               (size_t)(hit - map) < end) {
+            last = hit; // la última de la ventana es la más reciente
+            p = hit + 1;
+        }
+        if (last != NULL) {
+            size_t n = entry_at((size_t)(last - map));
+            if ((size_t)(last - map) + tlen <= offs[n] + entry_len(n)) { // no cruza un '\n'
+                return (long)n;
+            }
+            end = (size_t)(last - map); // cruzaba dos entradas: seguir antes
+            continue;
+        }
+        end = start;
+    }
+    return -1;
+}
+
+long history_search(const char *text, bool prefix, long before) {
+    assert(text != NULL);
+    history_refresh();
+    size_t from = (before < 0 || (size_t)before > n_entries) ? n_entries : (size_t)before;
+    size_t tlen = strlen(text);
+    if (tlen == 0) {
+        return from > 0 ? (long)from - 1 : -1;
+    }
+    return prefix ? search_prefix(text, tlen, from) : search_substring(text, tlen, from);
+}
+
+static void print_entry(size_t n) {
+    printf("%6zu  %.*s\n", n + 1, (int)entry_len(n), map + offs[n]);
+}
+
+void history_print_matches(const char *text, bool prefix) {
+    assert(text != NULL);
+    history_refresh();
+    size_t tlen = strlen(text);
+    if (prefix || tlen == 0) {
+        for (size_t n = 0; n < n_entries; n++) {
+            if (entry_len(n) >= tlen && memcmp(map + offs[n], text, tlen) == 0) {
+                print_entry(n);
+            }
+        }
+        return;
+    }
+    const char *p = map;
+    const char *end = map + indexed_len;
+    const char *hit;
+    while (p < end && (hit = memmem(p, (size_t)(end - p), text, tlen)) != NULL) {
+        size_t n = entry_at((size_t)(hit - map));
+        if ((size_t)(hit - map) + tlen <= offs[n] + entry_len(n)) {
+            print_entry(n);
+        }
+        p = map + offs[n] + entry_len(n) + 1; // sigue en la próxima entrada
+    }
+}
+
+void history_print_last(size_t n) {
+    history_refresh();
+    size_t first = n < n_entries ? n_entries - n : 0;
+    for (size_t i = first; i < n_entries; i++) {
+        print_entry(i);
+    }
+}
@@ -0,0 +1,74 @@
+/* Historial persistente de comandos.
+ *
+ * El historial es un archivo de texto con un comando por línea al que sólo
+ * se agrega al final (O_APPEND), por lo que varias sesiones pueden escribir
+ * en él a la vez. Para consultarlo se mapea en memoria con mmap y se indexa
+ * dónde empieza cada línea; el texto nunca se copia entero al heap. Las
+ * líneas que agregan otras sesiones se indexan al hacer la próxima consulta.
+ */
+
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+bool history_open(const char *path);
+/*
+ * Abre (o crea) el archivo de historial `path' y lo indexa.
+ * Devuelve false si no se pudo abrir; en ese caso las demás funciones no
+ * hacen nada.
+ *
+ * REQUIRES: path != NULL
+ */
+
+void history_close(void);
+/*
+ * Libera el mapeo y el índice y cierra el archivo.
+ */
+
+void history_add(const char *line);
+/*
+ * Agrega `line' (sin el '\n') al final del historial con una sola escritura.
+ * Las líneas en blanco y las repetidas con respecto a la anterior no se
+ * guardan.
+ *
+ * REQUIRES: line != NULL
+ */
+
+size_t history_count(void);
+/*
+ * Devuelve la cantidad de entradas del historial, incluidas las que
+ * agregaron otras sesiones.
+ */
+
+char *history_get(size_t n);
+/*
+ * Devuelve una copia de la entrada número `n' (0 es la más vieja), a liberar
+ * por el llamador, o NULL si no existe.
+ */
+
+long history_search(const char *text, bool prefix, long before);
+/*
+ * Busca hacia atrás, empezando por la entrada anterior a `before', la
+ * entrada más reciente que empieza con `text' (si `prefix') o que lo
+ * contiene. Con before < 0 se busca desde la última entrada.
+ * Devuelve el número de la entrada, o -1 si no hay ninguna.
+ *
+ * REQUIRES: text != NULL
+ */
+
+void history_print_matches(const char *text, bool prefix);
+/*
+ * Muestra por stdout, numeradas, todas las entradas que empiezan con `text'
+ * (si `prefix') o que lo contienen.
+ *
+ * REQUIRES: text != NULL
+ */
+
+void history_print_last(size_t n);
+/*
+ * Muestra por stdout, numeradas, las últimas `n' entradas.
+ */
+
+#endif
@@ -0,0 +1,460 @@
+#define _GNU_SOURCE     /* strndup(), getline() */
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include "lineedit.h"
+#include "history.h"
+#include "pathindex.h"
+
+#define KEY_CTRL(c) ((c) & 0x1f)   // Ctrl + tecla
+#define KEY_ESC 27
+#define KEY_BACKSPACE 127
+
+struct line_s {         // línea en edición
+    char *buf;
+    size_t len;
+    size_t cap;
+    size_t pos;         // posición del cursor
+    const char *prompt;
+};
+
+struct completions {    // candidatos de completado
+    char **v;
+    size_t n;
+    size_t cap;
+};
+
+static void line_reserve(struct line_s *l, size_t extra) {
+    if (l->len + extra + 1 > l->cap) {
+        while (l->len + extra + 1 > l->cap) {
+            l->cap = l->cap == 0 ? 128 : 2 * l->cap;
+        }
+        l->buf = realloc(l->buf, l->cap);
+    }
+}
+
+static void line_insert(struct line_s *l, const char *s, size_t n) {
+    line_reserve(l, n);
+    memmove(l->buf + l->pos + n, l->buf + l->pos, l->len - l->pos + 1);
+    memcpy(l->buf + l->pos, s, n);
+    l->len += n;
+    l->pos += n;
+}
+
+static void line_delete(struct line_s *l, size_t from, size_t to) { // borra [from, to)
+    memmove(l->buf + from, l->buf + to, l->len - to + 1);
+    l->len -= to - from;
+    if (l->pos > to) {
+        l->pos -= to - from;
+    } else if (l->pos > from) {
+        l->pos = from;
+    }
+}
+
+static void line_set(struct line_s *l, const char *s) {
+    l->len = l->pos = 0;
+    l->buf[0] = '\0';
+    line_insert(l, s, strlen(s));
+}
+
+static void refresh(const struct line_s *l) {
+    // redibuja la línea y deja el cursor en su lugar
+    printf("\r%s%.*s\x1b[K\r", l->prompt, (int)l->len, l->buf);
+    size_t col = strlen(l->prompt) + l->pos;
+    if (col > 0) {
+        printf("\x1b[%zuC", col);
+    }
+    fflush(stdout);
+}
+
+static int read_key(void) {
+    unsigned char c;
+    ssize_t r;
+    while ((r = read(STDIN_FILENO, &c, 1)) < 0 && errno == EINTR) {
+        // reintentar si nos interrumpió una señal
+    }
+    return r <= 0 ? -1 : c; // fin de archivo, o la terminal se colgó (EIO)
+}
+
+static int read_escape(void) {
+    // traduce las secuencias ESC [ x de flechas, Inicio, Fin y Supr
+    int a = read_key();
+    if (a != '[' && a != 'O') {
+        return 0;
+    }
+    int b = read_key();
+    if (b >= '0' && b <= '9') {
+        int tilde = read_key();
+        if (tilde != '~') {
+            return 0;
+        }
+        return b == '3' ? 'D' + 256 : (b == '1' || b == '7') ? 'H' : (b == '4' || b == '8') ? 'F' : 0;
+    }
+    return b;
+}
+
+/* Completado */
+
+static void comp_add(struct completions *c, char *s) {
+    if (c->n == c->cap) {
+        c->cap = c->cap == 0 ? 32 : 2 * c->cap;
+        c->v = realloc(c->v, c->cap * sizeof(char *));
+    }
+    c->v[c->n++] = s;
+}
+
+static void comp_free(struct completions *c) {
+    for (size_t i = 0; i < c->n; i++) {
+        free(c->v[i]);
+    }
+    free(c->v);
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void complete_path(const char *word, struct completions *out) {
+    // candidatos: entradas del directorio de `word' que empiezan con su última parte
+    const char *slash = strrchr(word, '/');
+    char *dir = slash != NULL ? strndup(word, (size_t)(slash - word) + 1) : strdup("");
+    const char *base = slash != NULL ? slash + 1 : word;
+    size_t blen = strlen(base);
+
+    DIR *d = opendir(dir[0] != '\0' ? dir : ".");
+    struct dirent *e;
+    while (d != NULL && (e = readdir(d)) != NULL) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..") ||
+            (e->d_name[0] == '.' && base[0] != '.') || strncmp(e->d_name, base, blen) != 0) {
+            continue;
+        }
+        size_t len = strlen(dir) + strlen(e->d_name) + 2;
+        char *cand = malloc(len);
+        snprintf(cand, len, "%s%s", dir, e->d_name);
+        struct stat st;
+        if (stat(cand, &st) == 0 && S_ISDIR(st.st_mode)) {
+            strcat(cand, "/"); // los directorios se completan con '/'
+        }
+        comp_add(out, cand);
+    }
+    if (d != NULL) {
+        closedir(d);
+    }
+    free(dir);
+    qsort(out->v, out->n, sizeof(char *), cmp_str);
+}
+
+static void complete_command(const char *word, struct completions *out) {
+    pathindex_update(); // sólo procesa los eventos de inotify pendientes
+    const char * const *first;
+    size_t n = pathindex_complete(word, &first);
+    for (size_t i = 0; i < n; i++) {
+        comp_add(out, strdup(first[i]));
+    }
+}
+
+static size_t common_prefix(const struct completions *c) {
+    size_t len = strlen(c->v[0]);
+    for (size_t i = 1; i < c->n; i++) {
+        size_t j = 0;
+        while (j < len && c->v[i][j] == c->v[0][j]) {
+            j++;
+        }
+        len = j;
+    }
+    return len;
+}
+
+static void show_completions(const struct line_s *l, const struct completions *c) {
+    struct winsize ws;
+    size_t width = 0;
+    size_t cols = ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 ? ws.ws_col : 80;
+    for (size_t i = 0; i < c->n; i++) {
+        size_t len = strlen(c->v[i]);
+        width = len > width ? len : width;
+    }
+    width += 2;
+    size_t per_row = cols / width > 0 ? cols / width : 1;
+    printf("\r\n");
+    for (size_t i = 0; i < c->n; i++) {
+        printf("%-*s", (int)width, c->v[i]);
+        if ((i + 1) % per_row == 0 || i + 1 == c->n) {
+            printf("\r\n");
+        }
+    }
+    refresh(l);
+}
+
+static void complete(struct line_s *l, bool list) {
+    size_t start = l->pos; // la palabra a completar termina en el cursor
+    while (start > 0 && l->buf[start - 1] != ' ' && l->buf[start - 1] != '\t') {
+        start--;
+    }
+    size_t before = start; // es un comando si antes sólo hay blancos o un '|'
+    while (before > 0 && (l->buf[before - 1] == ' ' || l->buf[before - 1] == '\t')) {
+        before--;
+    }
+    char *word = strndup(l->buf + start, l->pos - start);
+    bool is_command = (before == 0 || l->buf[before - 1] == '|') && strchr(word, '/') == NULL;
+
+    struct completions c = {NULL, 0, 0};
+    if (is_command) {
+        complete_command(word, &c);
+    } else {
+        complete_path(word, &c);
+    }
+
+    if (c.n == 1) {
+        const char *cand = c.v[0];
+        size_t clen = strlen(cand);
+        line_insert(l, cand + strlen(word), clen - strlen(word));
+        if (clen > 0 && cand[clen - 1] != '/') {
+            line_insert(l, " ", 1);
+        }
+    } else if (c.n > 1) {
+        size_t common = common_prefix(&c);
+        if (common > strlen(word)) {
+            line_insert(l, c.v[0] + strlen(word), common - strlen(word));
+        } else if (list) { // segundo Tab sin avance: mostrar candidatos
+            show_completions(l, &c);
+        } else {
+            putchar('\a');
+        }
+    } else {
+        putchar('\a');
+    }
+    comp_free(&c);
+    free(word);
+}
+
+/* Búsqueda en el historial (Ctrl-R) */
+
+static int reverse_search(struct line_s *l) {
+    // devuelve la tecla que terminó la búsqueda (la línea queda con el resultado)
+    char query[256] = "";
+    size_t qlen = 0;
+    long match = -1;
+    char *found = NULL;
+    int key;
+
+    for (;;) {
+        printf("\r(reverse-i-search)`%s': %s\x1b[K", query, found != NULL ? found : "");
+        fflush(stdout);
+        key = read_key();
+        if (key == KEY_CTRL('R') && qlen > 0) { // siguiente coincidencia más vieja
+            long older = history_search(query, false, match);
+            if (older >= 0) {
+                match = older;
+            }
+        } else if ((key == KEY_BACKSPACE || key == KEY_CTRL('H')) && qlen > 0) {
+            query[--qlen] = '\0';
+            match = history_search(query, false, -1);
+        } else if (key >= 32 && key < 127 && qlen + 1 < sizeof(query)) {
+            query[qlen++] = (char)key;
+            query[qlen] = '\0';
+            match = history_search(query, false, match >= 0 ? match + 1 : -1);
+        } else if (key != KEY_CTRL('R')) {
+            break;
+        }
+        free(found);
+        found = match >= 0 ? history_get((size_t)match) : NULL;
+    }
+
+    if (key == KEY_CTRL('G') || key == KEY_CTRL('C')) { // cancelar: la línea queda como estaba
+        free(found);
+        return key;
+    }
+    if (found != NULL) {
+        line_set(l, found);
+    }
+    free(found);
+    return key;
+}
+
+/* Lectura */
+
+static char *read_plain(const char *prompt) {
+    printf("%s", prompt);
+    fflush(stdout);
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len = getline(&line, &cap, stdin);
+    if (len < 0) {
+        free(line);
+        return NULL;
+    }
+    if (len > 0 && line[len - 1] == '\n') {
+        line[len - 1] = '\0';
+    }
+    return line;
+}
+
+char *lineedit_read(const char *prompt) {
+    assert(prompt != NULL);
+    struct termios orig;
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &orig) < 0) {
+        return read_plain(prompt);
+    }
+    struct termios raw = orig;
+    raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(tcflag_t)(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &raw); // sin descartar lo que se tipeó antes
+
+    struct line_s l = {NULL, 0, 0, 0, prompt};
+    line_reserve(&l, 0);
+    l.buf[0] = '\0';
+    size_t hist_pos = history_count(); // posición en el historial (count == línea nueva)
+    char *pending = NULL;               // lo que se estaba escribiendo antes de recorrer el historial
+    bool eof = false;
+    bool done = false;
+    int last_key = 0;
+
+    refresh(&l);
+    while (!done) {
+        int key = read_key();
+        if (key == KEY_CTRL('R')) {
+            key = reverse_search(&l);
+            if (key == '\r' || key == '\n') {
+                done = true;
+                continue;
+            }
+            refresh(&l);
+            if (key == KEY_CTRL('G') || key == KEY_CTRL('C')) {
+                continue;
+            }
+            // cualquier otra tecla termina la búsqueda y se procesa normalmente
+        }
+        if (key == KEY_ESC) {
+            key = read_escape();
+            key = key == 'A' ? KEY_CTRL('P') : key == 'B' ? KEY_CTRL('N') : key == 'C' ? KEY_CTRL('F') :
+                  key == 'D' ? KEY_CTRL('B') : key == 'H' ? KEY_CTRL('A') : key == 'F' ? KEY_CTRL('E') :
+                  key == 'D' + 256 ? 'D' + 256 : 0;
+        }
+
+        switch (key) {
+        case -1: // se cerró la entrada
+            eof = l.len == 0;
+            done = true;
+            break;
+        case '\r':
+        case '\n':
+            done = true;
+            break;
+        case KEY_CTRL('D'):
+            if (l.len == 0) {
+                eof = true;
+                done = true;
+            } else if (l.pos < l.len) {
+                line_delete(&l, l.pos, l.pos + 1);
+            }
+            break;
+        case 'D' + 256: // Supr
+            if (l.pos < l.len) {
+                line_delete(&l, l.pos, l.pos + 1);
+            }
+            break;
+        case KEY_BACKSPACE:
+        case KEY_CTRL('H'):
+            if (l.pos > 0) {
+                line_delete(&l, l.pos - 1, l.pos);
+            }
+            break;
+        case KEY_CTRL('C'): // descartar la línea
+            printf("^C\r\n");
+            l.len = l.pos = 0;
+            l.buf[0] = '\0';
+            hist_pos = history_count();
+            break;
+        case KEY_CTRL('A'):
+            l.pos = 0;
+            break;
+        case KEY_CTRL('E'):
+            l.pos = l.len;
+            break;
+        case KEY_CTRL('B'):
+            if (l.pos > 0) {
+                l.pos--;
+            }
+            break;
+        case KEY_CTRL('F'):
+            if (l.pos < l.len) {
+                l.pos++;
+            }
+            break;
+        case KEY_CTRL('K'):
+            line_delete(&l, l.pos, l.len);
+            break;
+        case KEY_CTRL('U'):
+            line_delete(&l, 0, l.pos);
+            break;
+        case KEY_CTRL('W'): { // borra la palabra anterior
+            size_t from = l.pos;
+            while (from > 0 && l.buf[from - 1] == ' ') {
+                from--;
+            }
+            while (from > 0 && l.buf[from - 1] != ' ') {
+                from--;
+            }
+            line_delete(&l, from, l.pos);
+            break;
+        }
+        case KEY_CTRL('L'):
+            printf("\x1b[H\x1b[2J");
+            break;
+        case KEY_CTRL('P'):
+        case KEY_CTRL('N'): {
+            size_t count = history_count();
+            if (key == KEY_CTRL('P') && hist_pos > 0) {
+                if (hist_pos == count) {
+                    free(pending);
+                    pending = strdup(l.buf);
+                }
+                hist_pos--;
+            } else if (key == KEY_CTRL('N') && hist_pos < count) {
+                hist_pos++;
+            } else {
+                break;
+            }
+            char *entry = hist_pos < count ? history_get(hist_pos) : NULL;
+            line_set(&l, entry != NULL ? entry : (pending != NULL ? pending : ""));
+            free(entry);
+            break;
+        }
+        case '\t':
+            complete(&l, last_key == '\t');
+            break;
+        default:
+            if (key >= 32 && key != KEY_BACKSPACE) {
+                char c = (char)key;
+                line_insert(&l, &c, 1);
+            }
+            break;
+        }
+        last_key = key;
+        if (!done) {
+            refresh(&l);
+        }
+    }
+
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &orig);
+    if (!eof) {
+        printf("\r\n");
+        fflush(stdout);
+    }
+    free(pending);
+    if (eof) {
+        free(l.buf);
+        return NULL;
+    }
+    return l.buf;
+}
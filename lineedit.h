@@ -0,0 +1,22 @@
+/* Editor de línea para la sesión interactiva.
+ *
+ * Teclas: flechas, Inicio/Fin, Ctrl-A/E/B/F para moverse; Backspace, Supr,
+ * Ctrl-K/U/W para borrar; flechas arriba/abajo y Ctrl-P/N recorren el
+ * historial; Ctrl-R busca hacia atrás en el historial; Tab completa nombres
+ * de comandos (desde el índice de $PATH) y caminos; Ctrl-C descarta la línea;
+ * Ctrl-D en una línea vacía es fin de archivo; Ctrl-L limpia la pantalla.
+ */
+
+#ifndef _LINEEDIT_H_
+#define _LINEEDIT_H_
+
+char *lineedit_read(const char *prompt);
+/*
+ * Muestra `prompt' y lee una línea, sin el '\n'. Si la entrada no es una
+ * terminal, la lee tal cual, sin edición.
+ * Devuelve la línea (a liberar por el llamador), o NULL en fin de archivo.
+ *
+ * REQUIRES: prompt != NULL
+ */
+
+#endif
@@ -0,0 +1,186 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lines.h"
+
+#define LINES_BLOCK (64 * 1024) // lo que se pide en cada lectura en bloque
+
+struct block_s {
+    char *buf;
+    size_t cap;
+    size_t len;     // bytes leídos en buf
+    off_t start;    // offset en el archivo de buf[0] (sólo archivos comunes)
+};
+
+// Último bloque leído de un archivo común, con lo necesario para saber si
+// sigue valiendo: mismo archivo, sin cambios de tamaño ni de fecha
+static struct {
+    struct block_s block;
+    bool valid;
+    bool busy;      // lo usa un lector abierto; otro lector usa su propio bloque
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+} cache;
+
+struct lines_s {
+    int fd;
+    bool seekable;          // archivo común: pread() y lseek() al cerrar
+    struct block_s *block;  // &cache.block, &own, o NULL si se lee de a un byte
+    struct block_s own;
+    size_t pos;             // primer byte de block sin entregar
+    char *line;             // la línea devuelta por lines_next()
+    size_t line_cap;
+};
+
+static bool cache_matches(const struct stat *st) {
+    return cache.valid && cache.dev == st->st_dev && cache.ino == st->st_ino &&
+           cache.size == st->st_size && cache.mtime.tv_sec == st->st_mtim.tv_sec &&
+           cache.mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+lines lines_open(int fd, bool to_end) {
+    assert(fd >= 0);
+    lines self = calloc(1, sizeof(struct lines_s));
+    self->fd = fd;
+    struct stat st;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        self->seekable = true;
+        if (cache.busy) {
+            self->block = &self->own;
+            self->own.start = offset;
+            return self;
+        }
+        cache.busy = true;
+        self->block = &cache.block;
+        if (cache_matches(&st) && offset >= cache.block.start &&
+            offset <= cache.block.start + (off_t)cache.block.len) {
+            self->pos = (size_t)(offset - cache.block.start); // sigue donde quedó la lectura anterior
+        } else {
+            cache.block.start = offset;
+            cache.block.len = 0;
+            cache.valid = true;
+            cache.dev = st.st_dev;
+            cache.ino = st.st_ino;
+            cache.size = st.st_size;
+            cache.mtime = st.st_mtim;
+        }
+    } else if (to_end) {
+        self->block = &self->own; // nadie más va a leer de este pipe
+    }
+    return self;
+}
+
+static ssize_t fill(lines self) {
+    // lee más datos al final del bloque, después de descartar lo ya
+    // entregado; devuelve lo que devolvió la lectura
+    struct block_s *b = self->block;
+    if (self->pos > 0) {
+        memmove(b->buf, b->buf + self->pos, b->len - self->pos);
+        b->len -= self->pos;
+        b->start += (off_t)self->pos;
+        self->pos = 0;
+    }
+    if (b->cap - b->len < LINES_BLOCK / 2) { // una línea muy larga: se agranda el bloque
+        b->cap = b->cap == 0 ? LINES_BLOCK : 2 * b->cap;
+        b->buf = realloc(b->buf, b->cap);
+    }
+    ssize_t r;
+    do {
+        if (self->seekable) {
+            r = pread(self->fd, b->buf + b->len, b->cap - b->len, b->start + (off_t)b->len);
+        } else {
+            r = read(self->fd, b->buf + b->len, b->cap - b->len);
+        }
+    } while (r < 0 && errno == EINTR);
+    if (r > 0) {
+        b->len += (size_t)r;
+    }
+    return r;
+}
+
+static const char *set_line(lines self, const char *text, size_t len) {
+    if (len + 1 > self->line_cap) {
+        self->line_cap = len + 1 > 2 * self->line_cap ? len + 1 : 2 * self->line_cap;
+        self->line = realloc(self->line, self->line_cap);
+    }
+    memcpy(self->line, text, len);
+    self->line[len] = '\0';
+    return self->line;
+}
+
+static const char *next_bytewise(lines self, size_t *len, bool *complete) {
+    // de a un byte: no se consume nada después del '\n'
+    size_t n = 0;
+    char c;
+    ssize_t r;
+    while ((r = read(self->fd, &c, 1)) != 0) {
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0 || c == '\n') {
+            break;
+        }
+        if (n + 1 >= self->line_cap) {
+            self->line_cap = self->line_cap == 0 ? 128 : 2 * self->line_cap;
+            self->line = realloc(self->line, self->line_cap);
+        }
+        self->line[n++] = c;
+    }
+    *complete = r == 1;
+    if (n == 0 && !*complete) {
+        return NULL;
+    }
+    if (self->line == NULL) { // una línea vacía como primera línea
+        self->line_cap = 128;
+        self->line = malloc(self->line_cap);
+    }
+    self->line[n] = '\0';
+    *len = n;
+    return self->line;
+}
+
+const char *lines_next(lines self, size_t *len, bool *complete) {
+    assert(self != NULL && len != NULL && complete != NULL);
+    if (self->block == NULL) {
+        return next_bytewise(self, len, complete);
+    }
+    for (;;) {
+        struct block_s *b = self->block;
+        char *start = b->buf + self->pos;
+        char *newline = memchr(start, '\n', b->len - self->pos);
+        if (newline != NULL) {
+            *len = (size_t)(newline - start);
+            *complete = true;
+            self->pos += *len + 1;
+            return set_line(self, start, *len);
+        }
+        if (fill(self) <= 0) { // fin (o error): lo que queda es una línea sin '\n'
+            *len = b->len - self->pos;
+            *complete = false;
+            if (*len == 0) {
+                return NULL;
+            }
+            self->pos = b->len;
+            return set_line(self, b->buf + b->len - *len, *len);
+        }
+    }
+}
+
+void lines_close(lines self) {
+    assert(self != NULL);
+    if (self->seekable) { // el próximo comando lee justo después de la última línea
+        lseek(self->fd, self->block->start + (off_t)self->pos, SEEK_SET);
+    }
+    if (self->block == &cache.block) {
+        cache.busy = false;
+    }
+    free(self->own.buf);
+    free(self->line);
+    free(self);
+}
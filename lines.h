@@ -0,0 +1,47 @@
+/* Lectura de líneas de un descriptor, para `read' y `mapfile'.
+ *
+ * Leer de a un byte es lo único seguro cuando el descriptor es un pipe o
+ * una terminal: lo que se lea de más ya no lo ve el próximo comando. Con un
+ * archivo común se puede leer en bloques grandes y al terminar volver el
+ * offset (lseek) justo después de la última línea entregada. El bloque
+ * leído queda guardado, así un ciclo de `read' sobre el mismo archivo no
+ * vuelve a leerlo: mientras el offset sea el que dejó la lectura anterior y
+ * el archivo no haya cambiado, cada línea sale del bloque sin leer nada.
+ */
+
+#ifndef _LINES_H_
+#define _LINES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct lines_s *lines;
+
+lines lines_open(int fd, bool to_end);
+/*
+ * Empieza a leer líneas de `fd' desde su offset actual. Con `to_end' se va
+ * a leer hasta el final, así que también un pipe se puede leer en bloques.
+ *
+ * REQUIRES: fd >= 0
+ * ENSURES: result != NULL
+ */
+
+const char *lines_next(lines self, size_t *len, bool *complete);
+/*
+ * Devuelve la próxima línea, sin el '\n' y terminada en '\0', o NULL si no
+ * queda nada o hubo un error de lectura. La cadena es del lector y vale
+ * hasta el próximo llamado. En *len queda su largo y en *complete si
+ * terminaba en '\n' (una última línea sin '\n' es incompleta).
+ *
+ * REQUIRES: self != NULL && len != NULL && complete != NULL
+ */
+
+void lines_close(lines self);
+/*
+ * Termina la lectura: deja el offset de un archivo común justo después de
+ * la última línea devuelta y libera el lector.
+ *
+ * REQUIRES: self != NULL
+ */
+
+#endif
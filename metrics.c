@@ -0,0 +1,194 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "metrics.h"
+#include "strextra.h"
+#include "vars.h"
+
+// Los histogramas usan cubetas de potencias de 2 en microsegundos: la
+// cubeta i cuenta los valores <= 2^i us; la última, todo lo demás
+#define METRIC_BUCKETS 26                       // hasta 2^24 us (~17 s) y +Inf
+#define METRICS_DEFAULT_INTERVAL 10             // segundos entre exportaciones
+
+struct histogram_s {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t buckets[METRIC_BUCKETS];
+};
+
+struct registry_s {
+    uint64_t counters[METRIC_COUNTERS];
+    struct histogram_s histograms[METRIC_HISTOGRAMS];
+};
+
+// Nombres para `stats' y para Prometheus, en el orden de los enums
+static const char *counter_names[METRIC_COUNTERS] = {
+    "pipelines", "stages", "spawn_failures", "builtin", "external", "audit_dropped"};
+static const char *counter_help[METRIC_COUNTERS] = {
+    "Pipelines ejecutados", "Procesos lanzados para comandos", "Comandos que no se pudieron lanzar",
+    "Líneas resueltas por un comando interno", "Líneas que lanzaron procesos",
+    "Registros de auditoría descartados con el buffer lleno"};
+static const char *histogram_names[METRIC_HISTOGRAMS] = {"parse", "spawn", "wait"};
+
+static struct registry_s *registry = NULL;
+static uint64_t last_export = 0;
+
+void metrics_init(void) {
+    void *mem = mmap(NULL, sizeof(struct registry_s), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    registry = mem != MAP_FAILED ? mem : NULL; // el mapeo anónimo ya viene en cero
+}
+
+void metrics_count(metric_counter_t counter) {
+    assert(counter < METRIC_COUNTERS);
+    if (registry != NULL) {
+        __atomic_fetch_add(&registry->counters[counter], 1, __ATOMIC_RELAXED);
+    }
+}
+
+uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_observe(metric_histogram_t histogram, uint64_t start) {
+    assert(histogram < METRIC_HISTOGRAMS);
+    if (registry == NULL) {
+        return;
+    }
+    uint64_t ns = metrics_now() - start;
+    uint64_t us = (ns + 999) / 1000;
+    unsigned int bucket = 0;
+    while (bucket < METRIC_BUCKETS - 1 && us > (1ull << bucket)) {
+        bucket++;
+    }
+    struct histogram_s *h = &registry->histograms[histogram];
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->buckets[bucket], 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t load(const uint64_t *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+// Cota superior, en us, del percentil `p' (0-100) según las cubetas
+static uint64_t percentile(const struct histogram_s *h, uint64_t count, unsigned int p) {
+    uint64_t rank = (count * p + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < METRIC_BUCKETS - 1; i++) {
+        seen += load(&h->buckets[i]);
+        if (seen >= rank) {
+            return 1ull << i;
+        }
+    }
+    return 0; // más allá de la última cubeta
+}
+
+static void print_bound(FILE *out, uint64_t us) {
+    if (us == 0) {
+        fprintf(out, "   >%lluus", 1ull << (METRIC_BUCKETS - 2));
+    } else {
+        fprintf(out, " <=%lluus", (unsigned long long)us);
+    }
+}
+
+void metrics_print(FILE *out) {
+    assert(out != NULL);
+    if (registry == NULL) {
+        return;
+    }
+    for (unsigned int i = 0; i < METRIC_COUNTERS; i++) {
+        fprintf(out, "%-15s %llu\n", counter_names[i],
+                (unsigned long long)load(&registry->counters[i]));
+    }
+    for (unsigned int i = 0; i < METRIC_HISTOGRAMS; i++) {
+        const struct histogram_s *h = &registry->histograms[i];
+        uint64_t count = load(&h->count);
+        fprintf(out, "%-15s count %llu", histogram_names[i], (unsigned long long)count);
+        if (count > 0) {
+            uint64_t sum = load(&h->sum_ns);
+            fprintf(out, "  avg %.1fus  p50", (double)sum / (double)count / 1000.0);
+            print_bound(out, percentile(h, count, 50));
+            fprintf(out, "  p90");
+            print_bound(out, percentile(h, count, 90));
+            fprintf(out, "  p99");
+            print_bound(out, percentile(h, count, 99));
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void metrics_print_prometheus(FILE *out) {
+    assert(out != NULL);
+    if (registry == NULL) {
+        return;
+    }
+    for (unsigned int i = 0; i < METRIC_COUNTERS; i++) {
+        fprintf(out, "# HELP mybash_%s_total %s.\n", counter_names[i], counter_help[i]);
+        fprintf(out, "# TYPE mybash_%s_total counter\n", counter_names[i]);
+        fprintf(out, "mybash_%s_total %llu\n", counter_names[i],
+                (unsigned long long)load(&registry->counters[i]));
+    }
+    for (unsigned int i = 0; i < METRIC_HISTOGRAMS; i++) {
+        const struct histogram_s *h = &registry->histograms[i];
+        const char *name = histogram_names[i];
+        fprintf(out, "# HELP mybash_%s_seconds Latencia de %s.\n", name, name);
+        fprintf(out, "# TYPE mybash_%s_seconds histogram\n", name);
+        uint64_t cumulative = 0;
+        for (unsigned int b = 0; b < METRIC_BUCKETS - 1; b++) {
+            cumulative += load(&h->buckets[b]);
+            fprintf(out, "mybash_%s_seconds_bucket{le=\"%g\"} %llu\n", name,
+                    (double)(1ull << b) / 1e6, (unsigned long long)cumulative);
+        }
+        cumulative += load(&h->buckets[METRIC_BUCKETS - 1]);
+        fprintf(out, "mybash_%s_seconds_bucket{le=\"+Inf\"} %llu\n", name,
+                (unsigned long long)cumulative);
+        uint64_t sum = load(&h->sum_ns);
+        fprintf(out, "mybash_%s_seconds_sum %.9f\n", name, (double)sum / 1e9);
+        fprintf(out, "mybash_%s_seconds_count %llu\n", name, (unsigned long long)load(&h->count));
+    }
+}
+
+void metrics_reset(void) {
+    if (registry != NULL) {
+        memset(registry, 0, sizeof(*registry));
+    }
+}
+
+int metrics_tick(void) {
+    const char *path = vars_get("MYBASH_METRICS");
+    if (registry == NULL || path == NULL || path[0] == '\0') {
+        return -1;
+    }
+    const char *interval_var = vars_get("MYBASH_METRICS_INTERVAL");
+    long interval = interval_var != NULL ? atol(interval_var) : METRICS_DEFAULT_INTERVAL;
+    if (interval <= 0) {
+        interval = METRICS_DEFAULT_INTERVAL;
+    }
+    uint64_t interval_ns = (uint64_t)interval * 1000000000u;
+
+    uint64_t now = metrics_now();
+    if (last_export != 0 && now - last_export < interval_ns) {
+        return (int)((interval_ns - (now - last_export)) / 1000000u) + 1;
+    }
+    last_export = now;
+
+    // se escribe en un temporal y se renombra: quien lo lee nunca ve un archivo a medias
+    char *tmp = strmerge((char *)path, ".tmp");
+    FILE *out = fopen(tmp, "w");
+    if (out != NULL) {
+        metrics_print_prometheus(out);
+        if (fclose(out) == 0) {
+            rename(tmp, path);
+        } else {
+            unlink(tmp);
+        }
+    }
+    free(tmp);
+    return (int)(interval_ns / 1000000u);
+}
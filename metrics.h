@@ -0,0 +1,92 @@
+/* Métricas del propio shell: contadores e histogramas de latencia.
+ *
+ * El registro vive en memoria compartida (mmap anónimo MAP_SHARED creado en
+ * metrics_init), así que lo que cuentan los hijos forkeados del shell, por
+ * ejemplo los del modo servidor, también queda registrado. Las
+ * actualizaciones son atómicas.
+ *
+ * Se consultan con el comando interno `stats' y, si la variable
+ * MYBASH_METRICS tiene un camino, se escriben ahí en el formato de texto de
+ * Prometheus cada MYBASH_METRICS_INTERVAL segundos (10 por defecto).
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    METRIC_PIPELINES,       // pipelines ejecutados
+    METRIC_STAGES,          // procesos lanzados para comandos
+    METRIC_SPAWN_FAILURES,  // comandos que no se pudieron lanzar
+    METRIC_BUILTIN,         // líneas resueltas por un comando interno
+    METRIC_EXTERNAL,        // líneas que lanzaron procesos
+    METRIC_AUDIT_DROPPED,   // registros de auditoría descartados con el buffer lleno
+    METRIC_COUNTERS         // cantidad de contadores, no es un contador
+} metric_counter_t;
+
+typedef enum {
+    METRIC_PARSE,           // parseo y expansión de una línea
+    METRIC_SPAWN,           // lanzar un comando (fork o zygote), visto desde el shell
+    METRIC_WAIT,            // esperar a que termine un pipeline
+    METRIC_HISTOGRAMS       // cantidad de histogramas, no es un histograma
+} metric_histogram_t;
+
+void metrics_init(void);
+/*
+ * Crea el registro. Antes de llamarla (o si falla) las demás funciones no
+ * registran nada.
+ */
+
+void metrics_count(metric_counter_t counter);
+/*
+ * Suma 1 al contador `counter'.
+ *
+ * REQUIRES: counter < METRIC_COUNTERS
+ */
+
+uint64_t metrics_now(void);
+/*
+ * Devuelve el instante actual en nanosegundos (reloj monótono), para
+ * medir con metrics_observe().
+ */
+
+void metrics_observe(metric_histogram_t histogram, uint64_t start);
+/*
+ * Registra en `histogram' el tiempo transcurrido desde `start', un valor
+ * devuelto por metrics_now().
+ *
+ * REQUIRES: histogram < METRIC_HISTOGRAMS
+ */
+
+void metrics_print(FILE *out);
+/*
+ * Muestra los contadores y un resumen de cada histograma (cantidad,
+ * promedio y percentiles aproximados).
+ *
+ * REQUIRES: out != NULL
+ */
+
+void metrics_print_prometheus(FILE *out);
+/*
+ * Escribe todas las métricas en el formato de texto de Prometheus.
+ *
+ * REQUIRES: out != NULL
+ */
+
+void metrics_reset(void);
+/*
+ * Pone en cero todos los contadores e histogramas.
+ */
+
+int metrics_tick(void);
+/*
+ * Si MYBASH_METRICS está definida y pasó el intervalo desde la última
+ * escritura, vuelve a escribir el archivo (de forma atómica, con rename).
+ * Devuelve cuántos milisegundos faltan para la próxima escritura, o -1 si
+ * no hay que exportar.
+ */
+
+#endif
@@ -1,52 +1,272 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "command.h"
-#include "execute.h"
 #include "parser.h"
 #include "parsing.h"
-#include "builtin.h"
+#include "options.h"
+#include "vars.h"
+#include "pathexp.h"
+#include "history.h"
+#include "strextra.h"
+#include "lineedit.h"
+#include "server.h"
+#include "zygote.h"
+#include "metrics.h"
+#include "bench.h"
+#include "record.h"
+#include "alloc.h"
+#include "flow.h"
+#include "coproc.h"
+#include "audit.h"
+#include "runner.h"
+#include "execute.h"
+
+extern char **environ;
+
+static void open_history(void)
+{
+    // $HISTFILE o ~/.mybash_history
+    const char *path = vars_get("HISTFILE");
+    const char *home = vars_get("HOME");
+    if (path != NULL) {
+        history_open(path);
+    } else if (home != NULL) {
+        char *file = strmerge((char *)home, "/.mybash_history");
+        history_open(file);
+        free(file);
+    }
+}
+
+static int run_line(char *line)
+{
+    // ejecuta una línea como la escribió el usuario y libera `line'; el
+    // estado queda en $?
+    int status = vars_get_status();
+    if (strspn(line, " \t") == strlen(line)) { // línea en blanco: nada que hacer
+        free(line);
+        return status;
+    }
+    if (bench_is_line(line)) { // bench recibe el pipeline sin parsear
+        status = bench_run(line);
+        vars_set_status(status);
+        free(line);
+        return status;
+    }
+    if (flow_is_compound(line)) { // if, while, for, funciones o varios comandos con `;'
+        status = flow_run(line);
+        free(line);
+        return status;
+    }
+
+    uint64_t parse_start = metrics_now();
+    alloc_phase_t phase = alloc_phase(ALLOC_PARSE);
+    bool arena = alloc_arena(option_get(OPT_ARENA)); // con `set -o arena', el pipeline sale de la arena
+    pipeline pipe = parse_pipeline_from_string(line);
+    alloc_arena(arena);
+    metrics_observe(METRIC_PARSE, parse_start);
+    free(line);
+    if (pipe != NULL)
+    {
+        status = flow_run_pipeline(pipe); // lo ejecuta y lo destruye
+    } else {
+        fprintf(stderr, "Error: comando inválido o error de sintaxis.\n");
+        status = 2;
+    }
+    pathexp_cache_reset(); // los listados de directorios valen sólo para esta línea
+    alloc_arena_reset();   // ya no queda nada de la línea en la arena
+    alloc_phase(phase);
+    vars_set_status(status); // queda en $?
+    return status;
+}
 
-static void show_prompt(void)
+static char *append_line(char *text, char *line)
 {
-    printf("mybash> ");
+    // text + "\n" + line; libera ambas
+    char *tmp = strmerge(text, "\n");
+    char *result = strmerge(tmp, line);
+    free(tmp);
+    free(text);
+    free(line);
+    return result;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int replay_session(const char *path, double speed)
+{
+    // reproduce una sesión grabada; speed 1 respeta los tiempos originales,
+    // 2 va el doble de rápido y 0 no espera entre líneas. Al final muestra
+    // en stderr cuánto tardó cada línea
+    replay session = replay_open(path);
+    if (session == NULL) {
+        return EXIT_FAILURE;
+    }
+    size_t n = 0, cap = 64;
+    uint64_t *latency = malloc(cap * sizeof(uint64_t));
+    char **texts = malloc(cap * sizeof(char *));
+    uint64_t start = metrics_now();
+    uint64_t target = 0; // instante de llegada de la línea, desde el comienzo
+
+    uint64_t delay_us;
+    char *line;
+    while ((line = replay_next(session, &delay_us)) != NULL) {
+        char *more;
+        uint64_t more_delay;
+        while (flow_incomplete(line) && (more = replay_next(session, &more_delay)) != NULL) {
+            line = append_line(line, more); // un bloque se ejecuta entero, cuando se cierra
+            delay_us += more_delay;
+        }
+        zygote_refill();
+        metrics_tick();
+        coproc_reap();
+        execute_reap();
+        if (speed > 0) {
+            target += (uint64_t)((double)delay_us * 1000 / speed);
+            uint64_t elapsed = metrics_now() - start;
+            if (target > elapsed) {
+                usleep((useconds_t)((target - elapsed) / 1000));
+            }
+        }
+        if (n == cap) {
+            cap *= 2;
+            latency = realloc(latency, cap * sizeof(uint64_t));
+            texts = realloc(texts, cap * sizeof(char *));
+        }
+        texts[n] = strdup(line);
+        uint64_t line_start = metrics_now();
+        run_line(line);
+        latency[n++] = metrics_now() - line_start;
+    }
+    replay_close(session);
     fflush(stdout);
+
+    double total = 0;
+    for (size_t i = 0; i < n; i++) {
+        fprintf(stderr, "replay %zu\t%.3f ms\t%s\n", i + 1, (double)latency[i] / 1e6, texts[i]);
+        total += (double)latency[i] / 1e6;
+        free(texts[i]);
+    }
+    if (n > 0) {
+        qsort(latency, n, sizeof(uint64_t), compare_u64);
+        fprintf(stderr, "replay: %zu líneas en %.3f ms (%.3f ms ejecutando); p50 %.3f  p90 %.3f  "
+                "p99 %.3f  max %.3f ms\n", n, (double)(metrics_now() - start) / 1e6, total,
+                (double)latency[(n - 1) * 50 / 100] / 1e6, (double)latency[(n - 1) * 90 / 100] / 1e6,
+                (double)latency[(n - 1) * 99 / 100] / 1e6, (double)latency[n - 1] / 1e6);
+    }
+    free(texts);
+    free(latency);
+    return vars_get_status();
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "uso: mybash [-c LÍNEA] [--record ARCHIVO] [--replay ARCHIVO [--speed X|max]] "
+                    "[--server SOCKET] [-P N SCRIPT...]\n");
 }
 
 int main(int argc, char *argv[])
 {
-    pipeline pipe;
-    Parser input;
     bool quit = false;
+    bool interactive = isatty(STDIN_FILENO); // sólo las sesiones interactivas guardan historial
+    const char *server_path = NULL;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *command = NULL;
+    double speed = 1;
+    unsigned int jobs = 0;      // con -P N: los scripts que siguen, N a la vez
+    char **scripts = NULL;
+    unsigned int nscripts = 0;
 
-    input = parser_new(stdin);
-    while (!quit)
-    {
-        show_prompt();
-        pipe = parse_pipeline(input);
-
-        quit = parser_at_eof(input);
-        if (pipe != NULL)
-        {
-            bool alone = builtin_alone(pipe); // vemos si el pipeline contiene un unico comando interno
-            if (alone) {
-                scommand front = pipeline_front(pipe);
-                builtin_run(front); // ejecutamos el comando interno
-            } else {
-                execute_pipeline(pipe); // si no es un comando interno, ejecutamos el pipeline normalmente
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--server") && i + 1 < argc) { // mybash --server SOCKET
+            server_path = argv[++i];
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) { // mybash -c 'ls | wc -l'
+            command = argv[++i];
+        } else if (!strcmp(argv[i], "-P") && i + 2 < argc) { // mybash -P 8 a.sh b.sh ...
+            char *end;
+            long n = strtol(argv[i + 1], &end, 10);
+            if (*end != '\0' || n <= 0) {
+                usage();
+                return 2;
+            }
+            jobs = (unsigned int)n;
+            scripts = argv + i + 2;
+            nscripts = (unsigned int)(argc - i - 2);
+            break;
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+            char *end;
+            const char *arg = argv[++i];
+            speed = !strcmp(arg, "max") ? 0 : strtod(arg, &end);
+            if (speed < 0 || (speed == 0 && strcmp(arg, "max") != 0)) {
+                usage();
+                return 2;
             }
-            pipe = pipeline_destroy(pipe);
         } else {
-            if (quit) { // si es EOF, salimos limpiamente (Ctrl+D)
-                putchar('\n');
-                quit = true;
-            } else {
-            fprintf(stderr, "Error: comando inválido o error de sintaxis.\n");
+            usage();
+            return 2;
+        }
+    }
+
+    vars_init(environ); // las variables heredadas quedan exportadas
+    metrics_init();
+    audit_init(); // con MYBASH_AUDIT=archivo
+    if (server_path != NULL) {
+        return server_run(server_path);
+    }
+    if (jobs > 0) {
+        return runner_run(jobs, scripts, nscripts, run_line);
+    }
+    if (command != NULL) { // una sola línea, sin REPL ni historial
+        return run_line(strdup(command));
+    }
+    if (replay_path != NULL) {
+        return replay_session(replay_path, speed);
+    }
+    if (record_path != NULL && !record_open(record_path)) {
+        return EXIT_FAILURE;
+    }
+    if (interactive) {
+        open_history();
+    }
+    while (!quit)
+    {
+        zygote_refill(); // con `set -o zygote', el pool se llena mientras se espera la línea
+        metrics_tick();  // exporta las métricas si pasó el intervalo
+        coproc_reap();   // los coprocesos que terminaron
+        execute_reap();  // y los pipelines en segundo plano
+        char *line = lineedit_read("mybash> ");
+        if (line == NULL) { // si es EOF, salimos limpiamente (Ctrl+D)
+            putchar('\n');
+            quit = true;
+            continue;
+        }
+        record_line(line); // con --record, la línea y cuándo llegó
+        if (interactive) {
+            history_add(line);
+        }
+        char *more;
+        while (flow_incomplete(line) && (more = lineedit_read("> ")) != NULL) {
+            record_line(more); // un bloque sigue hasta su fi, done o }
+            if (interactive) {
+                history_add(more);
             }
+            line = append_line(line, more);
         }
+        run_line(line);
     }
-    parser_destroy(input);
-    input = NULL;
+    record_close();
+    history_close();
     return EXIT_SUCCESS;
 }
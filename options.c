@@ -0,0 +1,35 @@
+#include <assert.h>
+#include <string.h>
+#include "options.h"
+
+// Nombres de las opciones, en el orden de shell_option_t
+static const char *option_names[OPT_COUNT] = {"xtrace", "plan", "globstar", "zygote", "arena", "gzip"};
+
+// Valores actuales; por defecto sólo está activa la planificación
+static bool option_values[OPT_COUNT] = {false, true, false, false, false, false};
+
+bool option_get(shell_option_t opt) {
+    assert(opt < OPT_COUNT);
+    return option_values[opt];
+}
+
+void option_set(shell_option_t opt, bool value) {
+    assert(opt < OPT_COUNT);
+    option_values[opt] = value;
+}
+
+const char *option_name(shell_option_t opt) {
+    assert(opt < OPT_COUNT);
+    return option_names[opt];
+}
+
+bool option_lookup(const char *name, shell_option_t *opt) {
+    assert(name != NULL && opt != NULL);
+    for (unsigned int i = 0; i < OPT_COUNT; i++) {
+        if (!strcmp(name, option_names[i])) {
+            *opt = (shell_option_t)i;
+            return true;
+        }
+    }
+    return false;
+}
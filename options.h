@@ -0,0 +1,49 @@
+/* Opciones del shell, modificables con el comando interno `set'.
+ */
+
+#ifndef _OPTIONS_H_
+#define _OPTIONS_H_
+
+#include <stdbool.h>
+
+typedef enum {
+    OPT_TRACE,      // xtrace: muestra cada pipeline antes de ejecutarlo
+    OPT_PLAN,       // plan: simplifica pipelines antes de ejecutarlos
+    OPT_GLOBSTAR,   // globstar: ** en un patrón recorre subdirectorios
+    OPT_ZYGOTE,     // zygote: lanza los comandos desde un pool de procesos pre-forkeados
+    OPT_ARENA,      // arena: lo que produce el parseo de una línea sale de una arena
+    OPT_GZIP,       // gzip: `> x.gz' comprime y `< x.gz' descomprime, sin lanzar gzip
+    OPT_COUNT       // cantidad de opciones, no es una opción
+} shell_option_t;
+
+bool option_get(shell_option_t opt);
+/*
+ * Indica si la opción `opt' está activada.
+ *
+ * REQUIRES: opt < OPT_COUNT
+ */
+
+void option_set(shell_option_t opt, bool value);
+/*
+ * Activa o desactiva la opción `opt'.
+ *
+ * REQUIRES: opt < OPT_COUNT
+ */
+
+const char *option_name(shell_option_t opt);
+/*
+ * Devuelve el nombre de la opción, el que se usa con `set -o nombre'.
+ * La cadena es estática y no debe liberarse.
+ *
+ * REQUIRES: opt < OPT_COUNT
+ */
+
+bool option_lookup(const char *name, shell_option_t *opt);
+/*
+ * Busca la opción de nombre `name' y la guarda en `opt'.
+ * Devuelve false si no existe ninguna opción con ese nombre.
+ *
+ * REQUIRES: name != NULL && opt != NULL
+ */
+
+#endif
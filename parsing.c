@@ -1,20 +1,509 @@
+#include <limits.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
+#include <ctype.h>
+#include <unistd.h>
 
 #include "parsing.h"
 #include "parser.h"
 #include "command.h"
+#include "strextra.h"
+#include "vars.h"
+#include "pathexp.h"
+#include "alloc.h"
 
-static char *limpiar_comillas(char *arg) { // elimina comillas simples o dobles que rodean el argumento
-    size_t len = strlen(arg);
-    if (len >= 2 && ((arg[0] == '"' && arg[len - 1] == '"') ||
-                     (arg[0] == '\'' && arg[len - 1] == '\''))) {
-        arg[len - 1] = '\0';
-        memmove(arg, arg + 1, len);
+struct word_buf { // cadena que crece mientras se expande una palabra
+    char *s;
+    size_t len;
+    size_t cap;
+    bool started;   // ya hay palabra aunque esté vacía (p.ej. "")
+};
+
+static void buf_putc(struct word_buf *b, char c) {
+    if (b->len + 1 >= b->cap) {
+        b->cap = b->cap == 0 ? 32 : 2 * b->cap;
+        b->s = realloc(b->s, b->cap);
+    }
+    b->s[b->len++] = c;
+    b->s[b->len] = '\0';
+    b->started = true;
+}
+
+static char *buf_take(struct word_buf *b) { // devuelve la palabra armada y deja el buffer vacío
+    char *word = b->s != NULL ? b->s : strdup("");
+    b->s = NULL;
+    b->len = b->cap = 0;
+    b->started = false;
+    return word;
+}
+
+static bool defer_expansion = false; // parse_template(): no expandir al parsear
+
+static char *join_args(void) { // "$1 $2 ...", el valor de $@ y $*
+    char *joined = strdup("");
+    for (unsigned int i = 1; i <= vars_arg_count(); i++) {
+        char *tmp = strmerge(joined, i > 1 ? " " : "");
+        free(joined);
+        joined = strmerge(tmp, (char *)vars_get_arg(i));
+        free(tmp);
+    }
+    return joined;
+}
+
+static const char *lookup_var(const char *name, char *tmp, size_t tmp_len, char **owned) {
+    // valor de $name ("" si no existe); si hubo que armarlo, queda también
+    // en *owned para que el llamador lo libere
+    if (isdigit((unsigned char)name[0])) {
+        const char *arg = name[0] == '0' ? "mybash" : vars_get_arg((unsigned int)(name[0] - '0'));
+        return arg != NULL ? arg : "";
+    }
+    if (!strcmp(name, "#")) {
+        snprintf(tmp, tmp_len, "%u", vars_arg_count());
+        return tmp;
+    }
+    if (!strcmp(name, "@") || !strcmp(name, "*")) {
+        *owned = join_args();
+        return *owned;
+    }
+    if (!strcmp(name, "$")) {
+        snprintf(tmp, tmp_len, "%d", (int)getpid());
+        return tmp;
+    }
+    if (!strcmp(name, "?")) {
+        snprintf(tmp, tmp_len, "%d", vars_get_status());
+        return tmp;
+    }
+    const char *value = vars_get(name);
+    return value != NULL ? value : "";
+}
+
+static size_t parse_var_name(const char *s, char *name, size_t name_len) {
+    // lee el nombre luego de un '$' (NAME, {NAME}, $, ?, #, @, * o un
+    // dígito); devuelve cuántos caracteres consumió, o 0 si no hay un nombre
+    // válido
+    size_t n = 0;
+    if (s[0] != '\0' && strchr("$?#@*0123456789", s[0]) != NULL) {
+        snprintf(name, name_len, "%c", s[0]);
+        return 1;
+    }
+    if (s[0] == '{') {
+        const char *close = strchr(s, '}');
+        if (close == NULL || !vars_valid_name(s + 1, (size_t)(close - s - 1)) ||
+            (size_t)(close - s) > name_len) {
+            return 0;
+        }
+        snprintf(name, name_len, "%.*s", (int)(close - s - 1), s + 1);
+        return (size_t)(close - s) + 1;
+    }
+    while (isalnum((unsigned char)s[n]) || s[n] == '_') {
+        n++;
+    }
+    if (!vars_valid_name(s, n) || n >= name_len) {
+        return 0;
+    }
+    snprintf(name, name_len, "%.*s", (int)n, s);
+    return n;
+}
+
+struct word_state { // palabra en construcción durante la expansión
+    struct word_buf text;   // la palabra tal como queda
+    struct word_buf pat;    // la misma palabra como patrón, con lo citado escapado
+    bool magic;             // tiene comodines sin comillas
+};
+
+static void word_putc(struct word_state *w, char c, bool quoted) {
+    buf_putc(&w->text, c);
+    if (c == '\\' || (quoted && (c == '*' || c == '?' || c == '['))) {
+        buf_putc(&w->pat, '\\'); // en el patrón vale literal
+    } else if (c == '*' || c == '?' || c == '[') {
+        w->magic = true;
+    }
+    buf_putc(&w->pat, c);
+}
+
+static void word_emit(struct word_state *w, scommand out) { // agrega la palabra (o los archivos que coinciden)
+    char **matches = NULL;
+    unsigned int n = w->magic ? pathexp_expand(w->pat.s, &matches) : 0;
+    if (n == 0) { // sin comodines o sin coincidencias: la palabra queda literal
+        scommand_push_back(out, buf_take(&w->text));
+    } else {
+        for (unsigned int i = 0; i < n; i++) {
+            scommand_push_back(out, matches[i]);
+        }
+        free(matches);
+        free(buf_take(&w->text));
+    }
+    free(buf_take(&w->pat));
+    w->magic = false;
+}
+
+static void expand_word(const char *word, bool split, scommand out, char **single) {
+    // quita comillas y expande variables y comodines en `word'. Con `split'
+    // las expansiones sin comillas se separan en palabras por los blancos,
+    // los comodines se reemplazan por los archivos que coinciden y cada
+    // palabra resultante se agrega a `out'; si no, el resultado se deja en
+    // *single como una sola palabra
+    struct word_state w = {{NULL, 0, 0, false}, {NULL, 0, 0, false}, false};
+    char quote = '\0';
+    if (split && vars_arg_count() == 0 && !strcmp(word, "\"$@\"")) {
+        return; // "$@" sin parámetros no deja ninguna palabra
+    }
+
+    for (size_t i = 0; word[i] != '\0'; i++) {
+        char c = word[i];
+        if (quote == '\0' && (c == '\'' || c == '"') && strchr(word + i + 1, c) != NULL) {
+            quote = c; // comilla que abre (sólo si cierra: las sueltas quedan literales)
+            w.text.started = true;
+        } else if (quote != '\0' && c == quote) {
+            quote = '\0';
+        } else if (c == '$' && quote != '\'') {
+            char name[256];
+            char tmp[32];
+            size_t used = parse_var_name(word + i + 1, name, sizeof(name));
+            if (used == 0) {
+                word_putc(&w, c, quote != '\0'); // un '$' sin nombre queda literal
+                continue;
+            }
+            i += used;
+            if (split && quote == '"' && !strcmp(name, "@")) { // "$@": cada parámetro, una palabra
+                for (unsigned int n = 1; n <= vars_arg_count(); n++) {
+                    if (n > 1) {
+                        word_emit(&w, out);
+                    }
+                    for (const char *arg = vars_get_arg(n); *arg != '\0'; arg++) {
+                        word_putc(&w, *arg, true);
+                    }
+                    w.text.started = true;
+                }
+                continue;
+            }
+            char *owned = NULL;
+            const char *value = lookup_var(name, tmp, sizeof(tmp), &owned);
+            for (; *value != '\0'; value++) {
+                if (split && quote == '\0' && isspace((unsigned char)*value)) {
+                    if (w.text.len > 0) {
+                        word_emit(&w, out); // separa en palabras
+                    }
+                } else {
+                    word_putc(&w, *value, quote != '\0');
+                }
+            }
+            free(owned);
+        } else {
+            word_putc(&w, c, quote != '\0');
+        }
+    }
+
+    if (split) {
+        if (w.text.started || w.text.len > 0) { // una expansión vacía sin comillas no deja palabra
+            word_emit(&w, out);
+        }
+        free(w.text.s);
+        free(w.pat.s);
+    } else {
+        *single = buf_take(&w.text);
+        free(w.pat.s);
+    }
+}
+
+static void expand_scommand(scommand sc) { // expande argumentos y redirecciones de un comando simple
+    unsigned int len = scommand_length(sc);
+    unsigned int nsubs = scommand_procsub_count(sc);
+    unsigned int *slots = malloc((nsubs + 1) * sizeof(unsigned int)); // lugar de cada marcador, antes y después
+    unsigned int *moved = malloc((nsubs + 1) * sizeof(unsigned int));
+    for (unsigned int n = 0; n < nsubs; n++) {
+        bool output;
+        scommand_get_procsub(sc, n, &output, &slots[n]);
+        moved[n] = UINT_MAX;
+    }
+    for (unsigned int i = 0; i < len; i++) { // rota la secuencia reemplazando cada argumento
+        char *arg = strdup(scommand_front(sc));
+        scommand_pop_front(sc);
+        unsigned int n = 0;
+        while (n < nsubs && slots[n] != i) {
+            n++;
+        }
+        if (n < nsubs) { // ya se expandió al parsear el pipeline interno
+            moved[n] = scommand_length(sc) - (len - i - 1); // los argumentos ya expandidos
+            scommand_push_back(sc, arg);
+        } else {
+            expand_word(arg, true, sc, NULL);
+            free(arg);
+        }
+    }
+    for (unsigned int n = 0; n < nsubs; n++) {
+        scommand_set_procsub_slot(sc, n, moved[n]);
+    }
+    free(slots);
+    free(moved);
+
+    char *redir = scommand_get_redir_in(sc);
+    if (redir != NULL) {
+        char *expanded;
+        expand_word(redir, false, NULL, &expanded);
+        scommand_set_redir_in(sc, expanded);
+    }
+    redir = scommand_get_redir_out(sc);
+    if (redir != NULL) {
+        char *expanded;
+        expand_word(redir, false, NULL, &expanded);
+        scommand_set_redir_out(sc, expanded);
+    }
+    for (unsigned int n = 0; n < scommand_fdredir_count(sc); n++) {
+        int fd;
+        scommand_get_fdredir(sc, n, &fd, &redir); // también N>&$VAR (coproc)
+        char *expanded;
+        expand_word(redir, false, NULL, &expanded);
+        scommand_set_fdredir_target(sc, n, expanded);
+    }
+}
+
+static void expand_pipeline(pipeline p) { // los pipelines anidados se expanden al parsearlos
+    unsigned int i = 0;
+    while (i < pipeline_length(p)) {
+        scommand sc = pipeline_nth(p, i);
+        expand_scommand(sc);
+        if (scommand_is_empty(sc)) { // p.ej. "$VACIA": no queda comando para ejecutar
+            pipeline_remove(p, i);
+        } else {
+            i++;
+        }
+    }
+}
+
+bool parse_duration(const char *word, unsigned long *ms) { // "5", "5s", "500ms", "1.5m", "2h"
+    assert(word != NULL && ms != NULL);
+    char *end;
+    double value = strtod(word, &end);
+    if (end == word || value < 0) return false;
+    double scale;
+    if (*end == '\0' || !strcmp(end, "s")) {
+        scale = 1000;
+    } else if (!strcmp(end, "ms")) {
+        scale = 1;
+    } else if (!strcmp(end, "m")) {
+        scale = 60 * 1000;
+    } else if (!strcmp(end, "h")) {
+        scale = 60 * 60 * 1000;
+    } else {
+        return false;
     }
-    return arg;
+    *ms = (unsigned long)(value * scale + 0.5);
+    return *ms > 0;
+}
+
+static void parse_prefixes(pipeline p) { // prefijos del shell delante del primer comando
+    scommand sc = pipeline_front(p);
+    // timeout DURACIÓN, cpus LISTA, nice -n N (o nice -N), ionice CLASE[:NIVEL],
+    // cgroup NOMBRE: sólo si el argumento es válido y queda un comando después
+    while (scommand_length(sc) > 2) {
+        const char *name = scommand_front(sc);
+        const char *arg = scommand_nth(sc, 1);
+        unsigned long ms;
+        if (!strcmp(name, "nice") && !strcmp(arg, "-n")) { // nice -n N es nice -N
+            char *adjust = scommand_length(sc) > 3 ? strmerge("-", scommand_nth(sc, 2)) : NULL;
+            bool ok = adjust != NULL && placement_prefix(pipeline_placement(p), name, adjust);
+            free(adjust);
+            if (!ok) {
+                break;
+            }
+            scommand_pop_front(sc);
+        } else if (!strcmp(name, "timeout") && parse_duration(arg, &ms)) {
+            pipeline_set_timeout(p, ms);
+        } else if (!placement_prefix(pipeline_placement(p), name, arg)) {
+            break;
+        }
+        scommand_pop_front(sc);
+        scommand_pop_front(sc);
+    }
+}
+
+static int delim_balance(const char *s, char open, char close) {
+    // cuenta `open' menos `close' en la palabra, sin los que están entre
+    // comillas o escapados: <(echo "a)b")
+    int balance = 0;
+    char quote = '\0';
+    for (; *s != '\0'; s++) {
+        if (*s == '\\' && quote != '\'' && s[1] != '\0') {
+            s++;
+        } else if (quote != '\0') {
+            if (*s == quote) quote = '\0';
+        } else if (*s == '\'' || *s == '"') {
+            quote = *s;
+        } else if (*s == open) {
+            balance++;
+        } else if (*s == close) {
+            balance--;
+        }
+    }
+    return balance;
+}
+
+static char *append_word(char *text, const char *sep, const char *word) { // text + sep + word, libera text
+    char *tmp = strmerge(text, (char *)sep);
+    free(text);
+    text = strmerge(tmp, (char *)word);
+    free(tmp);
+    return text;
+}
+
+static char *collect_delimited(Parser parser, char *first, char open, char close) {
+    // `first` es un argumento que empieza con `open`; consume palabras,
+    // redirecciones y pipes hasta el `close` que lo balancea y devuelve el
+    // texto que quedó entre ambos, o NULL si la línea termina antes
+    int depth = delim_balance(first, open, close);
+    char *text = strdup(first + 1);
+    free(first);
+    bool error = false;
+
+    while (depth > 0 && !error) { // consume palabras, redirecciones y pipes hasta cerrar el paréntesis
+        parser_skip_blanks(parser);
+        arg_kind_t type;
+        char *arg = parser_next_argument(parser, &type);
+        if (arg != NULL) {
+            const char *sep = type == ARG_INPUT ? " < " : (type == ARG_OUTPUT ? " > " : " ");
+            depth += delim_balance(arg, open, close);
+            text = append_word(text, sep, arg);
+            free(arg);
+        } else if (type == ARG_NORMAL && !parser_at_eof(parser)) {
+            bool has_pipe = false;
+            parser_op_pipe(parser, &has_pipe);
+            if (has_pipe) {
+                text = append_word(text, " ", "|");
+            } else {
+                error = true; // fin de línea antes del cierre
+            }
+        } else {
+            error = true;
+        }
+    }
+
+    size_t len = strlen(text);
+    if (error || depth < 0 || len == 0 || text[len - 1] != close) {
+        free(text);
+        return NULL;
+    }
+    text[len - 1] = '\0'; // quita el delimitador de cierre
+    return text;
+}
+
+static pipeline parse_procsub(Parser parser, char *first) { // lee el resto de <(...) o >(...) y lo parsea
+    char *text = collect_delimited(parser, first, '(', ')');
+    if (text == NULL) {
+        return NULL;
+    }
+    pipeline inner = parse_pipeline_from_string(text);
+    free(text);
+    return inner;
+}
+
+static bool parse_fanout(Parser parser, pipeline result) { // lee {c1, c2, ...} luego de |&
+    parser_skip_blanks(parser);
+    arg_kind_t type;
+    char *first = parser_next_argument(parser, &type);
+    if (first == NULL || type != ARG_NORMAL || first[0] != '{') {
+        free(first);
+        return false;
+    }
+    char *text = collect_delimited(parser, first, '{', '}');
+    if (text == NULL) {
+        return false;
+    }
+
+    bool ok = true;
+    int depth = 0;
+    char *start = text;
+    for (char *c = text; ok; c++) { // separa los consumidores por las comas de primer nivel
+        if (*c == '(' || *c == '{') depth++;
+        if (*c == ')' || *c == '}') depth--;
+        if (*c == '\0' || (*c == ',' && depth == 0)) {
+            bool end = (*c == '\0');
+            *c = '\0';
+            pipeline consumer = parse_pipeline_from_string(start);
+            if (consumer == NULL) {
+                ok = false;
+            } else {
+                pipeline_push_fanout(result, consumer);
+            }
+            if (end) break;
+            start = c + 1;
+        }
+    }
+    free(text);
+    return ok && pipeline_fanout_count(result) > 0;
+}
+
+#define FDREDIR_MARK '\x01'          // empieza la palabra de una redirección ya reconocida
+static const char fdredir_kinds[] = "rwad"; // FDREDIR_READ, _WRITE, _APPEND, _DUP
+
+static size_t scan_target(const char *s) {
+    // largo de la palabra destino de una redirección: hasta un blanco o un
+    // operador que no estén entre comillas
+    size_t n = 0;
+    char quote = '\0';
+    for (; s[n] != '\0' && (quote != '\0' || strchr(" \t\n|&<>", s[n]) == NULL); n++) {
+        if (quote == '\0' && (s[n] == '\'' || s[n] == '"')) {
+            quote = s[n];
+        } else if (s[n] == quote) {
+            quote = '\0';
+        }
+    }
+    return n;
+}
+
+static char *mark_fd_redirs(const char *line) {
+    // el lexer sólo conoce `< archivo' y `> archivo': N>archivo, N<archivo,
+    // [N]>>archivo y [N]>&M (o N<&M) se reescriben como una sola palabra
+    // FDREDIR_MARK N tipo destino, que parse_scommand() convierte en
+    // redirección
+    size_t len = strlen(line);
+    char *out = malloc(2 * len + 1); // cada redirección crece a lo sumo 2 caracteres
+    size_t n = 0;
+    char quote = '\0';
+    for (size_t i = 0; i < len;) {
+        char c = line[i];
+        if (quote != '\0' || c == '\'' || c == '"') {
+            quote = quote == '\0' ? c : (c == quote ? '\0' : quote);
+            out[n++] = line[i++];
+            continue;
+        }
+        bool word_start = i == 0 || strchr(" \t|", line[i - 1]) != NULL;
+        size_t digits = word_start ? strspn(line + i, "0123456789") : 0;
+        size_t op = i + digits;
+        if ((line[op] != '<' && line[op] != '>') || digits > 1) {
+            out[n++] = line[i++];
+            continue;
+        }
+        int fd = digits == 1 ? line[i] - '0' : (line[op] == '<' ? 0 : 1);
+        char kind = '\0';
+        size_t start = op + 1; // primer carácter del destino
+        if (line[op] == '>' && line[op + 1] == '>') {
+            kind = 'a';
+            start = op + 2;
+        } else if (line[op + 1] == '&' && (((isdigit((unsigned char)line[op + 2]) || line[op + 2] == '-') &&
+                                            strchr(" \t\n|&<>", line[op + 3]) != NULL) ||
+                                           line[op + 2] == '$')) {
+            kind = 'd';
+            start = op + 2;
+        } else if (digits == 1 && line[op + 1] != '(') { // sin N, queda para el lexer
+            kind = line[op] == '<' ? 'r' : 'w';
+        }
+        start += strspn(line + start, " \t");
+        size_t target = scan_target(line + start);
+        if (kind == '\0' || target == 0) { // no es una de estas (o le falta el destino)
+            out[n++] = line[i++];
+            continue;
+        }
+        if (n > 0 && strchr(" \t|", out[n - 1]) == NULL) { // echo hola>>log: la marca es otra palabra
+            out[n++] = ' ';
+        }
+        n += (size_t)sprintf(out + n, "%c%d%c%.*s", FDREDIR_MARK, fd, kind, (int)target, line + start);
+        i = start + target;
+    }
+    out[n] = '\0';
+    return out;
 }
 
 static scommand parse_scommand(Parser parser) { // analiza y construye un comando simple a partir del parser
@@ -28,18 +517,34 @@ static scommand parse_scommand(Parser parser) { // analiza y construye un comand
         arg_kind_t type;
         char *arg = parser_next_argument(parser, &type); // obtiene el siguiente argumento y su tipo
 
-        if (arg != NULL) {
+        if (arg != NULL && type == ARG_NORMAL && arg[0] == FDREDIR_MARK) { // ver mark_fd_redirs()
+            char *kind;
+            int fd = (int)strtol(arg + 1, &kind, 10);
+            fdredir_t redir = (fdredir_t)(strchr(fdredir_kinds, *kind) - fdredir_kinds);
+            scommand_push_back_fdredir(result, fd, redir, strdup(kind + 1));
+            free(arg);
+        } else if (arg != NULL) {
             if (type == ARG_NORMAL) { // si es un argumento normal, lo agrega al comando
                 saw_any_normal = true;
-                arg = limpiar_comillas(arg);
-                scommand_push_back(result, arg);
+                scommand_push_back(result, arg); // comillas y variables se resuelven al expandir
             }
 
-            if (type == ARG_INPUT) { // si es redirección de entrada, la establece en el comando
+            if ((type == ARG_INPUT || type == ARG_OUTPUT) && arg[0] == '(') { // sustitución de procesos <(...) o >(...)
+                pipeline inner = parse_procsub(parser, arg);
+                if (inner == NULL) {
+                    scommand_destroy(result);
+                    return NULL;
+                }
+                saw_any_normal = true;
+                scommand_push_back_procsub(result, inner, type == ARG_OUTPUT);
+            } else if ((type == ARG_INPUT || type == ARG_OUTPUT) && scommand_fdredir_count(result) > 0) {
+                // después de un 2>&1 (o similar) el orden importa: `cmd 2>&1 >/dev/null' deja
+                // stderr en la terminal. < y > van a la misma lista, que se aplica en orden
+                scommand_push_back_fdredir(result, type == ARG_INPUT ? 0 : 1,
+                                           type == ARG_INPUT ? FDREDIR_READ : FDREDIR_WRITE, arg);
+            } else if (type == ARG_INPUT) { // si es redirección de entrada, la establece en el comando
                 scommand_set_redir_in(result, arg);
-            }
-
-            if (type == ARG_OUTPUT) { // si es redirección de salida, la establece en el comando
+            } else if (type == ARG_OUTPUT) { // si es redirección de salida, la establece en el comando
                 scommand_set_redir_out(result, arg);
             }
 
@@ -89,6 +594,13 @@ pipeline parse_pipeline(Parser parser)
 
         if (!has_pipe) break; // si no hay pipe, termina el ciclo
 
+        bool is_fanout = false; // |& reparte la salida entre varios consumidores
+        parser_op_background(parser, &is_fanout);
+        if (is_fanout) {
+            error = !parse_fanout(parser, result);
+            break; // el reparto cierra el pipeline
+        }
+
         cmd = parse_scommand(parser); 
         if (cmd == NULL) {
             error = true;
@@ -111,7 +623,83 @@ pipeline parse_pipeline(Parser parser)
 
     if (error || pipeline_is_empty(result) || garbage) { // si hubo error, el pipeline está vacío o hay basura, libera y retorna NULL
         result = pipeline_destroy(result);
+    } else if (!defer_expansion) {
+        alloc_phase_t phase = alloc_phase(ALLOC_EXPAND);
+        expand_pipeline(result); // quita comillas y expande $VARIABLES
+        alloc_phase(phase);
+        if (!pipeline_is_empty(result)) {
+            parse_prefixes(result);
+        }
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+pipeline parse_pipeline_from_string(const char *line)
+{
+    assert(line != NULL);
+    char *text = mark_fd_redirs(line);
+    size_t len = strlen(text);
+    text = realloc(text, len + 2);
+    text[len] = '\n'; // el parser espera que el pipeline termine en fin de línea
+    text[len + 1] = '\0';
+
+    FILE *input = fmemopen(text, len + 1, "r");
+    if (input == NULL) {
+        free(text);
+        return NULL;
+    }
+    Parser parser = parser_new(input);
+    pipeline result = NULL;
+    if (parser != NULL) {
+        result = parse_pipeline(parser);
+        parser_destroy(parser);
+    }
+    fclose(input);
+    free(text);
+    return result;
+}
+
+pipeline parse_template(const char *line)
+{
+    assert(line != NULL);
+    bool previous = defer_expansion;
+    defer_expansion = true; // también para los pipelines anidados
+    pipeline result = parse_pipeline_from_string(line);
+    defer_expansion = previous;
+    return result;
+}
+
+static void expand_nested(pipeline p) { // como al parsear: primero los anidados, después p
+    for (unsigned int i = 0; i < pipeline_length(p); i++) {
+        scommand sc = pipeline_nth(p, i);
+        for (unsigned int n = 0; n < scommand_procsub_count(sc); n++) {
+            bool output;
+            unsigned int slot;
+            expand_nested(scommand_get_procsub(sc, n, &output, &slot));
+        }
+    }
+    for (unsigned int i = 0; i < pipeline_fanout_count(p); i++) {
+        expand_nested(pipeline_get_fanout(p, i));
+    }
+    expand_pipeline(p);
+    if (!pipeline_is_empty(p)) {
+        parse_prefixes(p);
+    }
+}
+
+pipeline parse_instantiate(const pipeline template)
+{
+    assert(template != NULL);
+    pipeline result = pipeline_copy(template);
+    alloc_phase_t phase = alloc_phase(ALLOC_EXPAND);
+    expand_nested(result);
+    alloc_phase(phase);
+    return result;
+}
+
+void parse_expand_words(scommand words)
+{
+    assert(words != NULL);
+    expand_scommand(words);
+}
@@ -20,4 +20,56 @@ pipeline parse_pipeline(Parser parser);
  *     estructura correspondiente.
  */
 
+pipeline parse_pipeline_from_string(const char *line);
+/*
+ * Igual que parse_pipeline(), pero leyendo el pipeline desde la cadena
+ * `line` (sin el \n final). Se usa para los pipelines anidados, como los de
+ * la sustitución de procesos <(...) y >(...).
+ * Devuelve un nuevo pipeline (a liberar por el llamador), o NULL en caso
+ * de error.
+ * REQUIRES:
+ *     line != NULL
+ */
+
+pipeline parse_template(const char *line);
+/*
+ * Como parse_pipeline_from_string(), pero sin expandir: las palabras quedan
+ * con sus comillas, $VARIABLES y comodines, y no se interpretan los
+ * prefijos. Es la forma en que se guardan los comandos de un bloque que se
+ * ejecuta muchas veces (ver flow.h), para no volver a parsearlos.
+ * Devuelve un nuevo pipeline (a liberar por el llamador), o NULL en caso
+ * de error.
+ * REQUIRES:
+ *     line != NULL
+ */
+
+pipeline parse_instantiate(const pipeline template);
+/*
+ * Copia un pipeline de parse_template() y lo expande, incluidos los
+ * pipelines anidados, con los valores actuales de las variables. El
+ * resultado es el mismo que daría parse_pipeline_from_string() con el
+ * mismo texto.
+ * Devuelve un nuevo pipeline (a liberar por el llamador).
+ * REQUIRES:
+ *     template != NULL
+ */
+
+void parse_expand_words(scommand words);
+/*
+ * Expande en el lugar cada palabra de `words' (comillas, variables y
+ * comodines), como los argumentos de un comando.
+ * REQUIRES:
+ *     words != NULL
+ */
+
+bool parse_duration(const char *word, unsigned long *ms);
+/*
+ * Interpreta una duración como las del prefijo `timeout': un número,
+ * posiblemente con decimales, seguido de ms, s (por defecto), m o h.
+ * Guarda en `ms' la duración en milisegundos.
+ * Devuelve false si `word' no es una duración positiva.
+ * REQUIRES:
+ *     word != NULL && ms != NULL
+ */
+
 #endif
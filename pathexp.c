@@ -0,0 +1,316 @@
+#define _GNU_SOURCE     /* fnmatch() con FNM_PERIOD */
+#include <assert.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "pathexp.h"
+#include "options.h"
+#include "alloc.h"
+
+#define GETDENTS_BUF (256 * 1024)   // bytes por llamada a getdents64
+#define CACHE_SLOTS 32              // directorios que recuerda el caché
+
+struct linux_dirent64 {             // formato de las entradas de getdents64
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct listing_s {                  // contenido de un directorio
+    char *path;                     // prefijo tal como aparece en el patrón ("" es ".")
+    char *names;                    // nombres uno detrás de otro, cada uno con su '\0'
+    size_t names_len;
+    size_t *offs;                   // dónde empieza cada nombre en `names'
+    unsigned char *types;           // d_type de cada entrada
+    size_t n;
+    unsigned int pins;              // recorridos en curso; no se puede descartar
+    bool cached;                    // está en el caché (si no, se libera al soltarlo)
+};
+
+struct match_list {                 // resultados que se van juntando
+    char **v;
+    size_t n;
+    size_t cap;
+};
+
+static struct listing_s *cache[CACHE_SLOTS];
+static unsigned int cache_next = 0; // próximo lugar a reemplazar cuando está lleno
+static char *dents_buf = NULL;
+
+static void listing_free(struct listing_s *l) {
+    free(l->path);
+    free(l->names);
+    free(l->offs);
+    free(l->types);
+    free(l);
+}
+
+void pathexp_cache_reset(void) {
+    for (unsigned int i = 0; i < CACHE_SLOTS; i++) {
+        if (cache[i] != NULL) {
+            listing_free(cache[i]);
+            cache[i] = NULL;
+        }
+    }
+    cache_next = 0;
+}
+
+static struct listing_s *listing_read(const char *path) {
+    int fd = open(path[0] != '\0' ? path : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (dents_buf == NULL) { // dura más que la línea: no sale de la arena
+        bool arena = alloc_arena(false);
+        dents_buf = malloc(GETDENTS_BUF);
+        alloc_arena(arena);
+    }
+
+    struct listing_s *l = calloc(1, sizeof(struct listing_s));
+    size_t cap = 0;
+    size_t names_cap = 0;
+    long nread;
+    while ((nread = syscall(SYS_getdents64, fd, dents_buf, GETDENTS_BUF)) > 0) {
+        for (long pos = 0; pos < nread;) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(dents_buf + pos);
+            pos += d->d_reclen;
+            if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, "..")) {
+                continue;
+            }
+            size_t len = strlen(d->d_name) + 1;
+            if (l->n == cap) {
+                cap = cap == 0 ? 256 : 2 * cap;
+                l->offs = realloc(l->offs, cap * sizeof(size_t));
+                l->types = realloc(l->types, cap);
+            }
+            if (l->names_len + len > names_cap) {
+                names_cap = names_cap == 0 ? 8192 : 2 * names_cap;
+                while (l->names_len + len > names_cap) {
+                    names_cap *= 2;
+                }
+                l->names = realloc(l->names, names_cap);
+            }
+            memcpy(l->names + l->names_len, d->d_name, len);
+            l->offs[l->n] = l->names_len;
+            l->types[l->n] = d->d_type;
+            l->names_len += len;
+            l->n++;
+        }
+    }
+    close(fd);
+    l->path = strdup(path);
+    return l;
+}
+
+static struct listing_s *listing_get(const char *path) {
+    // devuelve el listado de `path' fijado hasta listing_release()
+    for (unsigned int i = 0; i < CACHE_SLOTS; i++) {
+        if (cache[i] != NULL && !strcmp(cache[i]->path, path)) {
+            cache[i]->pins++;
+            return cache[i]; // ya se leyó en esta línea
+        }
+    }
+    struct listing_s *l = listing_read(path);
+    if (l == NULL) {
+        return NULL;
+    }
+    l->pins = 1;
+    for (unsigned int tries = 0; tries < CACHE_SLOTS && !l->cached; tries++) {
+        unsigned int slot = cache_next;
+        cache_next = (cache_next + 1) % CACHE_SLOTS;
+        if (cache[slot] == NULL || cache[slot]->pins == 0) { // no reemplaza listados en uso
+            if (cache[slot] != NULL) {
+                listing_free(cache[slot]);
+            }
+            cache[slot] = l;
+            l->cached = true;
+        }
+    }
+    return l;
+}
+
+static void listing_release(struct listing_s *l) {
+    if (l != NULL) {
+        l->pins--;
+        if (!l->cached) { // no entró en el caché (recorrido muy profundo)
+            listing_free(l);
+        }
+    }
+}
+
+bool pathexp_has_magic(const char *pattern) {
+    assert(pattern != NULL);
+    for (const char *c = pattern; *c != '\0'; c++) {
+        if (*c == '\\' && c[1] != '\0') {
+            c++;
+        } else if (*c == '*' || *c == '?' || *c == '[') {
+            return true;
+        }
+    }
+    return false;
+}
+
+static char *join(const char *prefix, const char *name, const char *suffix) {
+    size_t lp = strlen(prefix);
+    size_t ln = strlen(name);
+    size_t ls = strlen(suffix);
+    char *res = malloc(lp + ln + ls + 1);
+    memcpy(res, prefix, lp);
+    memcpy(res + lp, name, ln);
+    memcpy(res + lp + ln, suffix, ls + 1);
+    return res;
+}
+
+static void match_add(struct match_list *m, char *path) {
+    if (m->n == m->cap) {
+        m->cap = m->cap == 0 ? 16 : 2 * m->cap;
+        m->v = realloc(m->v, m->cap * sizeof(char *));
+    }
+    m->v[m->n++] = path;
+}
+
+static bool entry_is_dir(const char *prefix, const char *name, unsigned char type, bool follow) {
+    if (type == DT_DIR) {
+        return true;
+    }
+    if (type != DT_UNKNOWN && !(type == DT_LNK && follow)) {
+        return false;
+    }
+    char *path = join(prefix, name, "");
+    struct stat st;
+    bool res = (follow ? stat(path, &st) : lstat(path, &st)) == 0 && S_ISDIR(st.st_mode);
+    free(path);
+    return res;
+}
+
+static char *unescape(const char *comp) {
+    char *res = malloc(strlen(comp) + 1);
+    size_t j = 0;
+    for (const char *c = comp; *c != '\0'; c++) {
+        if (*c == '\\' && c[1] != '\0') {
+            c++;
+        }
+        res[j++] = *c;
+    }
+    res[j] = '\0';
+    return res;
+}
+
+static void glob_rec(const char *prefix, char **comps, size_t ncomps, struct match_list *out) {
+    const char *comp = comps[0];
+    bool last = (ncomps == 1);
+
+    if (last && comp[0] == '\0') { // patrón terminado en '/': sólo directorios
+        match_add(out, strdup(prefix));
+        return;
+    }
+
+    if (!strcmp(comp, "**") && option_get(OPT_GLOBSTAR)) { // cero o más directorios
+        struct listing_s *l = listing_get(prefix);
+        if (!last) {
+            glob_rec(prefix, comps + 1, ncomps - 1, out);
+        }
+        for (size_t i = 0; l != NULL && i < l->n; i++) {
+            const char *name = l->names + l->offs[i];
+            if (name[0] == '.') {
+                continue;
+            }
+            if (last) {
+                match_add(out, join(prefix, name, ""));
+            }
+            if (entry_is_dir(prefix, name, l->types[i], false)) { // no sigue enlaces
+                char *sub = join(prefix, name, "/");
+                glob_rec(sub, comps, ncomps, out);
+                free(sub);
+            }
+        }
+        listing_release(l);
+        return;
+    }
+
+    if (!pathexp_has_magic(comp)) { // componente fijo: no hace falta listar salvo al final
+        char *name = unescape(comp);
+        if (last) {
+            struct listing_s *l = listing_get(prefix);
+            for (size_t i = 0; l != NULL && i < l->n; i++) {
+                if (!strcmp(l->names + l->offs[i], name)) {
+                    match_add(out, join(prefix, name, ""));
+                    break;
+                }
+            }
+            listing_release(l);
+        } else {
+            char *sub = join(prefix, name, "/");
+            glob_rec(sub, comps + 1, ncomps - 1, out);
+            free(sub);
+        }
+        free(name);
+        return;
+    }
+
+    struct listing_s *l = listing_get(prefix);
+    for (size_t i = 0; l != NULL && i < l->n; i++) {
+        const char *name = l->names + l->offs[i];
+        if (fnmatch(comp, name, FNM_PERIOD) != 0) {
+            continue;
+        }
+        if (last) {
+            match_add(out, join(prefix, name, ""));
+        } else if (entry_is_dir(prefix, name, l->types[i], true)) {
+            char *sub = join(prefix, name, "/");
+            glob_rec(sub, comps + 1, ncomps - 1, out);
+            free(sub);
+        }
+    }
+    listing_release(l);
+}
+
+static int cmp_paths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+unsigned int pathexp_expand(const char *pattern, char ***matches) {
+    assert(pattern != NULL && matches != NULL);
+
+    // separa el patrón en componentes por '/'
+    char *copy = strdup(pattern);
+    size_t ncomps = 0;
+    char **comps = malloc((strlen(pattern) / 2 + 2) * sizeof(char *));
+    char *p = copy;
+    const char *prefix = "";
+    if (*p == '/') {
+        prefix = "/";
+        while (*p == '/') {
+            p++;
+        }
+    }
+    comps[ncomps++] = p;
+    for (; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            while (p[1] == '/') { // a//b es a/b
+                p++;
+            }
+            comps[ncomps++] = p + 1;
+        }
+    }
+
+    struct match_list out = {NULL, 0, 0};
+    glob_rec(prefix, comps, ncomps, &out);
+    free(comps);
+    free(copy);
+
+    if (out.n > 1) {
+        qsort(out.v, out.n, sizeof(char *), cmp_paths);
+    }
+    *matches = out.v;
+    return (unsigned int)out.n;
+}
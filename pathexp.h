@@ -0,0 +1,39 @@
+/* Expansión de nombres de archivo (globbing): *, ?, [...] y, con la opción
+ * `globstar', ** para recorrer subdirectorios.
+ *
+ * Los directorios se leen con getdents64 en bloques grandes y su listado se
+ * guarda en un caché de corta vida: varios patrones de una misma línea de
+ * comandos sobre el mismo directorio lo leen una sola vez. El caché se vacía
+ * con pathexp_cache_reset() al terminar cada línea.
+ */
+
+#ifndef _PATHEXP_H_
+#define _PATHEXP_H_
+
+#include <stdbool.h>
+
+bool pathexp_has_magic(const char *pattern);
+/*
+ * Indica si `pattern' tiene algún comodín (*, ? o [) sin escapar con '\'.
+ *
+ * REQUIRES: pattern != NULL
+ */
+
+unsigned int pathexp_expand(const char *pattern, char ***matches);
+/*
+ * Busca los caminos que coinciden con `pattern'. Un '\' escapa el carácter
+ * siguiente. Los archivos que empiezan con '.' sólo coinciden si el patrón
+ * también empieza con '.'.
+ * Devuelve la cantidad de coincidencias y en *matches un arreglo ordenado de
+ * cadenas nuevas (arreglo y cadenas a liberar por el llamador). Si no hay
+ * ninguna, devuelve 0 y deja *matches en NULL.
+ *
+ * REQUIRES: pattern != NULL && matches != NULL
+ */
+
+void pathexp_cache_reset(void);
+/*
+ * Descarta los listados de directorios guardados.
+ */
+
+#endif
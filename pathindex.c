@@ -0,0 +1,225 @@
+#define _GNU_SOURCE     /* strdup() con -std */
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "pathindex.h"
+#include "vars.h"
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF)
+
+struct watched_dir {
+    char *path;
+    int wd;                 // descriptor de inotify del directorio
+};
+
+static char **names = NULL; // ejecutables, ordenados y sin repetir
+static size_t n_names = 0;
+static size_t names_cap = 0;
+
+static struct watched_dir *dirs = NULL;
+static size_t n_dirs = 0;
+static int notify_fd = -1;
+static char *indexed_path = NULL;   // valor de $PATH con el que se armó el índice
+
+static bool is_executable(const char *dir, const char *name) {
+    int dfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) {
+        return false;
+    }
+    struct stat st;
+    bool res = fstatat(dfd, name, &st, 0) == 0 && S_ISREG(st.st_mode) &&
+               faccessat(dfd, name, X_OK, 0) == 0;
+    close(dfd);
+    return res;
+}
+
+static size_t lower_bound(const char *key) { // primera posición con nombre >= key
+    size_t lo = 0;
+    size_t hi = n_names;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strcmp(names[mid], key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void index_insert(const char *name) {
+    size_t pos = lower_bound(name);
+    if (pos < n_names && !strcmp(names[pos], name)) {
+        return; // ya estaba (p.ej. en otro directorio de $PATH)
+    }
+    if (n_names == names_cap) {
+        names_cap = names_cap == 0 ? 1024 : 2 * names_cap;
+        names = realloc(names, names_cap * sizeof(char *));
+    }
+    memmove(names + pos + 1, names + pos, (n_names - pos) * sizeof(char *));
+    names[pos] = strdup(name);
+    n_names++;
+}
+
+static void index_remove(const char *name) {
+    for (size_t i = 0; i < n_dirs; i++) { // sigue siendo ejecutable si está en otro directorio
+        if (is_executable(dirs[i].path, name)) {
+            return;
+        }
+    }
+    size_t pos = lower_bound(name);
+    if (pos < n_names && !strcmp(names[pos], name)) {
+        free(names[pos]);
+        memmove(names + pos, names + pos + 1, (n_names - pos - 1) * sizeof(char *));
+        n_names--;
+    }
+}
+
+static int cmp_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void scan_dir(const char *path) { // agrega los ejecutables de un directorio (sin ordenar)
+    int dfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR *d = dfd >= 0 ? fdopendir(dfd) : NULL;
+    if (d == NULL) {
+        if (dfd >= 0) {
+            close(dfd);
+        }
+        return;
+    }
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        struct stat st;
+        if (e->d_type != DT_REG && e->d_type != DT_LNK && e->d_type != DT_UNKNOWN) {
+            continue;
+        }
+        if (fstatat(dfd, e->d_name, &st, 0) == 0 && S_ISREG(st.st_mode) &&
+            faccessat(dfd, e->d_name, X_OK, 0) == 0) {
+            if (n_names == names_cap) {
+                names_cap = names_cap == 0 ? 1024 : 2 * names_cap;
+                names = realloc(names, names_cap * sizeof(char *));
+            }
+            names[n_names++] = strdup(e->d_name);
+        }
+    }
+    closedir(d);
+}
+
+static void index_build(const char *path) {
+    pathindex_destroy();
+    indexed_path = strdup(path);
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    char *copy = strdup(path);
+    char *save = NULL;
+    for (char *dir = strtok_r(copy, ":", &save); dir != NULL; dir = strtok_r(NULL, ":", &save)) {
+        dirs = realloc(dirs, (n_dirs + 1) * sizeof(struct watched_dir));
+        dirs[n_dirs].path = strdup(dir);
+        dirs[n_dirs].wd = notify_fd >= 0 ? inotify_add_watch(notify_fd, dir, WATCH_MASK) : -1;
+        n_dirs++;
+        scan_dir(dir);
+    }
+    free(copy);
+
+    // ordenar una sola vez y quitar repetidos
+    qsort(names, n_names, sizeof(char *), cmp_names);
+    size_t j = 0;
+    for (size_t i = 0; i < n_names; i++) {
+        if (j > 0 && !strcmp(names[j - 1], names[i])) {
+            free(names[i]);
+        } else {
+            names[j++] = names[i];
+        }
+    }
+    n_names = j;
+}
+
+static const char *dir_of_watch(int wd) {
+    for (size_t i = 0; i < n_dirs; i++) {
+        if (dirs[i].wd == wd) {
+            return dirs[i].path;
+        }
+    }
+    return NULL;
+}
+
+void pathindex_update(void) {
+    const char *path = vars_get("PATH");
+    if (path == NULL) {
+        path = "";
+    }
+    if (indexed_path == NULL || strcmp(indexed_path, path) != 0) {
+        index_build(path);
+        return;
+    }
+    if (notify_fd < 0) {
+        return;
+    }
+
+    char buf[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(notify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            const char *dir = dir_of_watch(ev->wd);
+            if (ev->mask & IN_Q_OVERFLOW) { // se perdieron eventos: armar de nuevo
+                index_build(path);
+                return;
+            }
+            if (dir == NULL || ev->len == 0 || ev->name[0] == '.') {
+                continue;
+            }
+            if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                index_remove(ev->name);
+            } else if (is_executable(dir, ev->name)) {
+                index_insert(ev->name);
+            } else if (ev->mask & IN_ATTRIB) { // le quitaron el permiso de ejecución
+                index_remove(ev->name);
+            }
+        }
+    }
+}
+
+size_t pathindex_complete(const char *prefix, const char * const **first) {
+    assert(prefix != NULL && first != NULL);
+    size_t len = strlen(prefix);
+    size_t lo = lower_bound(prefix);
+    size_t hi = lo;
+    while (hi < n_names && strncmp(names[hi], prefix, len) == 0) {
+        hi++;
+    }
+    *first = (const char * const *)(names + lo);
+    return hi - lo;
+}
+
+void pathindex_destroy(void) {
+    for (size_t i = 0; i < n_names; i++) {
+        free(names[i]);
+    }
+    for (size_t i = 0; i < n_dirs; i++) {
+        free(dirs[i].path);
+    }
+    if (notify_fd >= 0) {
+        close(notify_fd);
+    }
+    free(names);
+    free(dirs);
+    free(indexed_path);
+    names = NULL;
+    dirs = NULL;
+    indexed_path = NULL;
+    n_names = names_cap = n_dirs = 0;
+    notify_fd = -1;
+}
@@ -0,0 +1,36 @@
+/* Índice de los ejecutables de $PATH para completar nombres de comandos.
+ *
+ * El índice es un arreglo ordenado de nombres que se arma una sola vez. Cada
+ * directorio de $PATH queda vigilado con inotify, y los archivos que se crean,
+ * borran o renombran se agregan o quitan del índice a medida que llegan los
+ * eventos, sin volver a recorrer los directorios. Si cambia $PATH, el índice
+ * se arma de nuevo.
+ */
+
+#ifndef _PATHINDEX_H_
+#define _PATHINDEX_H_
+
+#include <stddef.h>
+
+void pathindex_update(void);
+/*
+ * Pone al día el índice: lo arma si todavía no existe o si cambió $PATH, y si
+ * no procesa los eventos de inotify pendientes. No bloquea.
+ */
+
+size_t pathindex_complete(const char *prefix, const char * const **first);
+/*
+ * Busca los ejecutables cuyo nombre empieza con `prefix'. Devuelve cuántos
+ * son y en *first deja el primero de ellos; los demás le siguen en orden
+ * alfabético. Las cadenas son propiedad del módulo y valen hasta la próxima
+ * llamada a pathindex_update().
+ *
+ * REQUIRES: prefix != NULL && first != NULL
+ */
+
+void pathindex_destroy(void);
+/*
+ * Libera el índice y deja de vigilar los directorios.
+ */
+
+#endif
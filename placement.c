@@ -0,0 +1,231 @@
+#define _GNU_SOURCE     /* sched_setaffinity(), CPU_SET */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <termios.h>
+#include "placement.h"
+#include "strextra.h"
+
+#define CGROUP_ROOT "/sys/fs/cgroup/"   // base de los nombres de cgroup relativos
+
+// ioprio_set(2) no tiene envoltorio en glibc
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_PRIO_VALUE(class, level) (((class) << IOPRIO_CLASS_SHIFT) | (level))
+
+// Clases de ionice(1): nombre, abreviatura y número
+static const struct {
+    const char *name;
+    const char *alias;
+    int class;
+} ioprio_classes[] = {
+    {"realtime", "rt", 1},
+    {"best-effort", "be", 2},
+    {"idle", "idle", 3},
+};
+
+static bool grouped = false;            // el proceso ya entró al grupo de su pipeline
+
+void placement_init(placement_t *place) {
+    assert(place != NULL);
+    memset(place, 0, sizeof(*place));
+    place->ioprio = -1;
+}
+
+void placement_clear(placement_t *place) {
+    assert(place != NULL);
+    free(place->cgroup);
+    free(place->spec);
+    placement_init(place);
+}
+
+bool placement_is_set(const placement_t *place) {
+    assert(place != NULL);
+    return place->has_cpus || place->has_nice || place->ioprio >= 0 || place->cgroup != NULL;
+}
+
+// "0-3,6" -> bits 0, 1, 2, 3 y 6
+static bool parse_cpus(const char *list, unsigned char *cpus) {
+    unsigned char set[PLACEMENT_MAX_CPUS / 8] = {0};
+    const char *s = list;
+    for (;;) {
+        char *end;
+        long first = strtol(s, &end, 10);
+        long last = first;
+        if (end == s || first < 0) {
+            return false;
+        }
+        if (*end == '-') {
+            s = end + 1;
+            last = strtol(s, &end, 10);
+            if (end == s || last < first) {
+                return false;
+            }
+        }
+        if (last >= PLACEMENT_MAX_CPUS) {
+            return false;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            set[cpu / 8] |= (unsigned char)(1u << (cpu % 8));
+        }
+        if (*end == '\0') {
+            break;
+        }
+        if (*end != ',') {
+            return false;
+        }
+        s = end + 1;
+    }
+    memcpy(cpus, set, sizeof(set));
+    return true;
+}
+
+// "idle", "be:7", "rt:0", "2:4" -> valor para ioprio_set
+static bool parse_ioprio(const char *arg, int *ioprio) {
+    char *colon = strchr(arg, ':');
+    size_t len = colon != NULL ? (size_t)(colon - arg) : strlen(arg);
+    int class = -1;
+    for (size_t i = 0; i < sizeof(ioprio_classes) / sizeof(ioprio_classes[0]); i++) {
+        const char *name = ioprio_classes[i].name;
+        const char *alias = ioprio_classes[i].alias;
+        if ((len == strlen(name) && !strncmp(arg, name, len)) ||
+            (len == strlen(alias) && !strncmp(arg, alias, len)) ||
+            (len == 1 && arg[0] == (char)('0' + ioprio_classes[i].class))) {
+            class = ioprio_classes[i].class;
+        }
+    }
+    if (class < 0) {
+        return false;
+    }
+    int level = class == 3 ? 0 : 4; // nivel por defecto, como ionice(1)
+    if (colon != NULL) {
+        char *end;
+        long l = strtol(colon + 1, &end, 10);
+        if (end == colon + 1 || *end != '\0' || l < 0 || l > 7 || class == 3) {
+            return false;
+        }
+        level = (int)l;
+    }
+    *ioprio = IOPRIO_PRIO_VALUE(class, level);
+    return true;
+}
+
+static void append_spec(placement_t *place, const char *name, const char *arg) {
+    char *tmp = strmerge(place->spec != NULL ? place->spec : "", (char *)name);
+    char *word = strmerge(" ", (char *)arg);
+    free(place->spec);
+    place->spec = strmerge(tmp, word);
+    free(tmp);
+    free(word);
+    tmp = strmerge(place->spec, " ");
+    free(place->spec);
+    place->spec = tmp;
+}
+
+bool placement_prefix(placement_t *place, const char *name, const char *arg) {
+    assert(place != NULL && name != NULL && arg != NULL);
+    if (!strcmp(name, "cpus")) {
+        if (!parse_cpus(arg, place->cpus)) {
+            return false;
+        }
+        place->has_cpus = true;
+    } else if (!strcmp(name, "nice")) { // como nice(1): -10 sube el nice 10, --10 lo baja
+        char *end;
+        long n = arg[0] == '-' ? strtol(arg + 1, &end, 10) : 0;
+        if (arg[0] != '-' || end == arg + 1 || *end != '\0' || n < -40 || n > 40) {
+            return false;
+        }
+        place->has_nice = true;
+        place->nice = (int)n;
+    } else if (!strcmp(name, "ionice")) {
+        if (!parse_ioprio(arg, &place->ioprio)) {
+            return false;
+        }
+    } else if (!strcmp(name, "cgroup")) {
+        if (arg[0] == '\0' || strstr(arg, "..") != NULL) {
+            return false;
+        }
+        free(place->cgroup);
+        place->cgroup = arg[0] == '/' ? strdup(arg) : strmerge(CGROUP_ROOT, (char *)arg);
+    } else {
+        return false;
+    }
+    append_spec(place, name, arg);
+    return true;
+}
+
+bool placement_apply(const placement_t *place) {
+    assert(place != NULL);
+    if (place->cgroup != NULL) { // primero el cgroup, así lo demás ya corre con sus límites
+        char *procs = strmerge(place->cgroup, "/cgroup.procs");
+        int fd = open(procs, O_WRONLY | O_CLOEXEC);
+        bool ok = fd >= 0 && write(fd, "0", 1) == 1; // "0": el proceso que escribe
+        int err = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(procs);
+        if (!ok) {
+            fprintf(stderr, "cgroup: no se pudo entrar a '%s': %s\n", place->cgroup, strerror(err));
+            return false;
+        }
+    }
+    if (place->has_cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < PLACEMENT_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+            if (place->cpus[cpu / 8] & (1u << (cpu % 8))) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+            fprintf(stderr, "cpus: %s\n", strerror(errno));
+            return false;
+        }
+    }
+    if (place->has_nice) {
+        errno = 0;
+        if (nice(place->nice) == -1 && errno != 0) {
+            fprintf(stderr, "nice: %s\n", strerror(errno));
+            return false;
+        }
+    }
+    if (place->ioprio >= 0 &&
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, place->ioprio) < 0) {
+        fprintf(stderr, "ionice: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void placement_terminal_to(pid_t pgid) {
+    // SIGTTOU se bloquea porque quien llama puede no estar en primer plano
+    sigset_t set, old;
+    sigemptyset(&set);
+    sigaddset(&set, SIGTTOU);
+    sigprocmask(SIG_BLOCK, &set, &old);
+    tcsetpgrp(STDIN_FILENO, pgid);
+    sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+void placement_join_group(pid_t pgid, bool foreground) {
+    if (pgid < 0) {
+        return;
+    }
+    setpgid(0, pgid);
+    grouped = true;
+    if (foreground) {
+        placement_terminal_to(getpgrp());
+    }
+}
+
+bool placement_in_group(void) {
+    return grouped;
+}
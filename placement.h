@@ -0,0 +1,86 @@
+/* Dónde corre un pipeline: grupo de procesos, CPUs, prioridad y cgroup.
+ *
+ * Los prefijos `cpus LISTA', `nice -n N' (o `nice -N'), `ionice CLASE[:NIVEL]' y
+ * `cgroup NOMBRE' delante de un pipeline se guardan en un placement_t y se
+ * aplican en cada hijo justo antes del exec, así que no hace falta lanzar
+ * procesos extra (como taskset, nice o ionice).
+ */
+
+#ifndef _PLACEMENT_H_
+#define _PLACEMENT_H_
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define PLACEMENT_MAX_CPUS 1024
+
+typedef struct {
+    bool has_cpus;
+    unsigned char cpus[PLACEMENT_MAX_CPUS / 8]; // afinidad, un bit por CPU (cpus 0-3,6)
+    bool has_nice;
+    int nice;               // incremento de nice (nice -n 10, nice -10)
+    int ioprio;             // clase y nivel de E/S para ioprio_set; -1 sin cambios
+    char *cgroup;           // directorio del cgroup v2; NULL sin cambios
+    char *spec;             // los prefijos tal como se escribieron, para mostrarlos
+} placement_t;
+
+void placement_init(placement_t *place);
+/*
+ * Deja `place' sin cambios de ubicación.
+ *
+ * REQUIRES: place != NULL
+ * ENSURES: !placement_is_set(place)
+ */
+
+void placement_clear(placement_t *place);
+/*
+ * Libera la memoria de `place' y lo deja como recién inicializado.
+ *
+ * REQUIRES: place != NULL
+ */
+
+bool placement_is_set(const placement_t *place);
+/*
+ * Indica si `place' pide algún cambio.
+ *
+ * REQUIRES: place != NULL
+ */
+
+bool placement_prefix(placement_t *place, const char *name, const char *arg);
+/*
+ * Si `name arg' es un prefijo válido (`cpus 0-3', `nice -5', `ionice idle',
+ * `ionice be:7', `cgroup lote'), lo agrega a `place' y devuelve true. Si no
+ * lo es, devuelve false y no modifica nada. `nice -N' es el de nice(1): -5
+ * suma 5 al nice y --5 le resta 5; `nice -n N' se pasa como `nice -N'.
+ *
+ * REQUIRES: place != NULL && name != NULL && arg != NULL
+ */
+
+bool placement_apply(const placement_t *place);
+/*
+ * Aplica `place' al proceso actual: lo mueve al cgroup y le fija la
+ * afinidad, el nice y la prioridad de E/S. Se llama en el hijo antes del
+ * exec. Si algo falla muestra el error y devuelve false.
+ *
+ * REQUIRES: place != NULL
+ */
+
+void placement_join_group(pid_t pgid, bool foreground);
+/*
+ * En el hijo: entra al grupo de procesos `pgid' (0: crea uno propio) y, si
+ * `foreground', le pasa la terminal. Con pgid < 0 no hace nada.
+ */
+
+bool placement_in_group(void);
+/*
+ * Indica si el proceso actual entró a un grupo con placement_join_group();
+ * los pipelines que ejecute quedan en ese mismo grupo.
+ */
+
+void placement_terminal_to(pid_t pgid);
+/*
+ * Pasa la terminal (la de la entrada estándar) al grupo `pgid'. Puede
+ * llamarse desde un proceso que no está en primer plano.
+ */
+
+#endif
@@ -0,0 +1,89 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "plan.h"
+#include "command.h"
+#include "options.h"
+
+// Indica si `sc' es un cat sin opciones ni sustituciones, con `nargs' archivos
+static bool is_plain_cat(scommand sc, unsigned int nargs) {
+    if (scommand_is_empty(sc) || strcmp(scommand_front(sc), "cat") != 0 ||
+        scommand_length(sc) != nargs + 1 || scommand_procsub_count(sc) > 0 ||
+        scommand_fdredir_count(sc) > 0) {
+        return false;
+    }
+    // el único argumento tiene que ser un archivo, no una opción ni "-"
+    return nargs == 0 || scommand_nth(sc, 1)[0] != '-';
+}
+
+// Aplica una sola reescritura; devuelve false si no encontró ninguna
+static bool plan_step(pipeline p) {
+    unsigned int len = pipeline_length(p);
+    if (len < 2) {
+        return false;
+    }
+
+    // cat archivo | cmd  /  cat < archivo | cmd
+    scommand first = pipeline_nth(p, 0);
+    scommand second = pipeline_nth(p, 1);
+    if (scommand_get_redir_out(first) == NULL && scommand_get_redir_in(second) == NULL) {
+        if (is_plain_cat(first, 1) && scommand_get_redir_in(first) == NULL) {
+            scommand_set_redir_in(second, strdup(scommand_nth(first, 1)));
+            pipeline_remove(p, 0);
+            return true;
+        }
+        if (is_plain_cat(first, 0) && scommand_get_redir_in(first) != NULL) {
+            scommand_set_redir_in(second, strdup(scommand_get_redir_in(first)));
+            pipeline_remove(p, 0);
+            return true;
+        }
+    }
+
+    // ... | cat | cmd
+    for (unsigned int i = 1; i + 1 < len; i++) {
+        scommand sc = pipeline_nth(p, i);
+        if (is_plain_cat(sc, 0) && scommand_get_redir_in(sc) == NULL &&
+            scommand_get_redir_out(sc) == NULL) {
+            pipeline_remove(p, i);
+            return true;
+        }
+    }
+
+    // ... | cmd | cat > salida; sin `> salida' no se toca: cmd dejaría de escribir
+    // en un pipe (ls acomoda en columnas, grep --color=auto colorea). Con
+    // reparto el último comando alimenta a los consumidores
+    scommand last = pipeline_nth(p, len - 1);
+    scommand prev = pipeline_nth(p, len - 2);
+    if (pipeline_fanout_count(p) == 0 && is_plain_cat(last, 0) && scommand_get_redir_in(last) == NULL &&
+        scommand_get_redir_out(last) != NULL && scommand_get_redir_out(prev) == NULL) {
+        scommand_set_redir_out(prev, strdup(scommand_get_redir_out(last)));
+        pipeline_remove(p, len - 1);
+        return true;
+    }
+
+    return false;
+}
+
+void plan_pipeline(pipeline p) {
+    assert(p != NULL);
+    if (!option_get(OPT_PLAN)) {
+        return;
+    }
+
+    char *before = option_get(OPT_TRACE) ? pipeline_to_string(p) : NULL;
+    bool changed = false;
+    while (plan_step(p)) { // hasta que no quede nada para simplificar
+        changed = true;
+    }
+
+    if (before != NULL) {
+        if (changed) {
+            char *after = pipeline_to_string(p);
+            fprintf(stderr, "+ plan: %s  =>  %s\n", before, after);
+            free(after);
+        }
+        free(before);
+    }
+}
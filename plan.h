@@ -0,0 +1,29 @@
+/* Planificación de pipelines: reescribe un pipeline recién parseado en uno
+ * equivalente con menos comandos simples, antes de ejecutarlo.
+ */
+
+#ifndef _PLAN_H_
+#define _PLAN_H_
+
+#include "command.h"
+
+void plan_pipeline(pipeline p);
+/*
+ * Simplifica `p' si la opción `plan' está activa. Reescrituras:
+ *
+ *   cat archivo | cmd ...      ->  cmd ... < archivo
+ *   cat < archivo | cmd ...    ->  cmd ... < archivo
+ *   ... | cat | cmd ...        ->  ... | cmd ...
+ *   ... | cmd | cat > salida   ->  ... | cmd > salida
+ *
+ * Sólo se aplican cuando el `cat' no tiene opciones y el comando vecino no
+ * tiene ya la redirección que se le traslada. Un `cat' final sin `> salida'
+ * queda: sin él, cmd escribiría en la terminal y no en un pipe, y muchos
+ * programas cambian su salida (ls, grep --color=auto). Con la opción
+ * `xtrace' activa se informa cada reescritura por stderr.
+ *
+ * REQUIRES: p != NULL
+ *
+ */
+
+#endif
@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "record.h"
+#include "metrics.h"
+
+#define RECORD_MAGIC "MYBREC1\n"
+#define RECORD_MAGIC_LEN 8
+#define VARINT_MAX 10               // bytes de un uint64_t en LEB128
+#define REPLAY_MAX_LINE (64 * 1024 * 1024) // un largo mayor sólo sale de un archivo dañado
+
+struct replay_s {
+    FILE *file;
+};
+
+static int record_fd = -1;
+static uint64_t record_last = 0;    // instante de la línea anterior
+
+// Escribe `value' en LEB128 al final de `buf'; devuelve los bytes usados
+static size_t put_varint(unsigned char *buf, uint64_t value) {
+    size_t n = 0;
+    do {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        buf[n++] = byte | (value != 0 ? 0x80 : 0);
+    } while (value != 0);
+    return n;
+}
+
+static bool get_varint(FILE *file, uint64_t *value) {
+    *value = 0;
+    for (unsigned int shift = 0; shift < 7 * VARINT_MAX; shift += 7) {
+        int c = getc(file);
+        if (c == EOF) {
+            return false;
+        }
+        *value |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool record_open(const char *path) {
+    assert(path != NULL);
+    record_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (record_fd < 0 || write(record_fd, RECORD_MAGIC, RECORD_MAGIC_LEN) != RECORD_MAGIC_LEN) {
+        fprintf(stderr, "mybash: %s: %s\n", path, strerror(errno));
+        record_close();
+        return false;
+    }
+    record_last = metrics_now();
+    return true;
+}
+
+void record_line(const char *line) {
+    assert(line != NULL);
+    if (record_fd < 0) {
+        return;
+    }
+    uint64_t now = metrics_now();
+    size_t len = strlen(line);
+    unsigned char *buf = malloc(2 * VARINT_MAX + len);
+    size_t n = put_varint(buf, (now - record_last) / 1000);
+    n += put_varint(buf + n, len);
+    memcpy(buf + n, line, len);
+    if (write(record_fd, buf, n + len) < 0) {
+        fprintf(stderr, "mybash: no se pudo grabar la línea: %s\n", strerror(errno));
+    }
+    free(buf);
+    record_last = now;
+}
+
+void record_close(void) {
+    if (record_fd >= 0) {
+        close(record_fd);
+        record_fd = -1;
+    }
+}
+
+replay replay_open(const char *path) {
+    assert(path != NULL);
+    FILE *file = fopen(path, "re");
+    if (file == NULL) {
+        fprintf(stderr, "mybash: %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    char magic[RECORD_MAGIC_LEN];
+    if (fread(magic, 1, RECORD_MAGIC_LEN, file) != RECORD_MAGIC_LEN ||
+        memcmp(magic, RECORD_MAGIC, RECORD_MAGIC_LEN) != 0) {
+        fprintf(stderr, "mybash: %s: no es una sesión grabada\n", path);
+        fclose(file);
+        return NULL;
+    }
+    replay self = malloc(sizeof(struct replay_s));
+    self->file = file;
+    return self;
+}
+
+char *replay_next(replay self, uint64_t *delay_us) {
+    assert(self != NULL && delay_us != NULL);
+    uint64_t len;
+    if (!get_varint(self->file, delay_us) || !get_varint(self->file, &len)) {
+        return NULL;
+    }
+    if (len > REPLAY_MAX_LINE) { // como un registro cortado
+        return NULL;
+    }
+    char *line = malloc(len + 1);
+    if (line == NULL || fread(line, 1, len, self->file) != len) { // registro cortado
+        free(line);
+        return NULL;
+    }
+    line[len] = '\0';
+    return line;
+}
+
+replay replay_close(replay self) {
+    assert(self != NULL);
+    fclose(self->file);
+    free(self);
+    return NULL;
+}
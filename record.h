@@ -0,0 +1,63 @@
+/* Grabación de sesiones para reproducirlas después (`mybash --record' y
+ * `mybash --replay').
+ *
+ * El archivo empieza con la firma "MYBREC1\n" y sigue con un registro por
+ * línea de entrada: los microsegundos desde la línea anterior y el largo
+ * del texto, ambos como enteros de largo variable (LEB128), y el texto sin
+ * el '\n'. Una línea típica ocupa sólo unos bytes más que su texto.
+ */
+
+#ifndef _RECORD_H_
+#define _RECORD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct replay_s * replay;
+
+bool record_open(const char *path);
+/*
+ * Empieza a grabar en `path' (lo crea o lo trunca).
+ * Devuelve false, con un mensaje, si no se puede abrir.
+ *
+ * REQUIRES: path != NULL
+ */
+
+void record_line(const char *line);
+/*
+ * Graba `line' con el tiempo transcurrido desde la anterior. Cada registro
+ * se escribe de una vez, así que una sesión cortada deja un archivo válido.
+ * No hace nada si no se está grabando.
+ *
+ * REQUIRES: line != NULL
+ */
+
+void record_close(void);
+/*
+ * Termina la grabación.
+ */
+
+replay replay_open(const char *path);
+/*
+ * Abre una grabación para leerla. Devuelve NULL, con un mensaje, si no se
+ * puede abrir o no es una grabación.
+ *
+ * REQUIRES: path != NULL
+ */
+
+char *replay_next(replay self, uint64_t *delay_us);
+/*
+ * Devuelve la siguiente línea (a liberar por el llamador) y en `delay_us'
+ * cuánto tiempo después de la anterior llegó, o NULL al final.
+ *
+ * REQUIRES: self != NULL && delay_us != NULL
+ */
+
+replay replay_close(replay self);
+/*
+ * Cierra la grabación. Devuelve NULL.
+ *
+ * REQUIRES: self != NULL
+ */
+
+#endif
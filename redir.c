@@ -0,0 +1,231 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "redir.h"
+
+// held[N]: descriptor del shell (>= REDIR_FDS) que los comandos reciben como N; -1 si no hay
+static int held[REDIR_FDS] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+static unsigned int nheld = 0;
+// hidden[N]: lo guardado para N es de un coproceso; un comando lo recibe sólo si lo nombra (>&N)
+static bool hidden[REDIR_FDS];
+
+static int open_flags(fdredir_t kind) {
+    if (kind == FDREDIR_READ) {
+        return O_RDONLY;
+    }
+    return O_WRONLY | O_CREAT | (kind == FDREDIR_APPEND ? O_APPEND : O_TRUNC);
+}
+
+static bool parse_fd(const char *text, int *fd) { // la M de N>&M
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || value < 0 || value >= REDIR_FDS) {
+        return false;
+    }
+    *fd = (int)value;
+    return true;
+}
+
+static void hold(int fd, int shell_fd) { // reemplaza lo guardado para fd (-1: nada)
+    if (held[fd] >= 0) {
+        close(held[fd]);
+        nheld--;
+    }
+    held[fd] = shell_fd;
+    hidden[fd] = false;
+    if (shell_fd >= 0) {
+        nheld++;
+    }
+}
+
+static bool exec_one(int fd, fdredir_t kind, const char *target) {
+    if (kind == FDREDIR_DUP && !strcmp(target, "-")) {
+        hold(fd, -1);
+        return true;
+    }
+    int source;
+    bool opened = false;
+    if (kind == FDREDIR_DUP) {
+        if (!parse_fd(target, &source)) {
+            fprintf(stderr, "%d>&%s: descriptor inválido\n", fd, target);
+            return false;
+        }
+        source = redir_fd(source);
+    } else {
+        source = open(target, open_flags(kind) | O_CLOEXEC, 0666);
+        if (source < 0) {
+            fprintf(stderr, "%s: %s\n", target, strerror(errno));
+            return false;
+        }
+        opened = true;
+    }
+    int shell_fd = fcntl(source, F_DUPFD_CLOEXEC, REDIR_FDS); // fuera del rango de los comandos
+    int saved = errno;
+    if (opened) {
+        close(source);
+    }
+    if (shell_fd < 0) {
+        fprintf(stderr, "%d: %s\n", fd, strerror(saved));
+        return false;
+    }
+    hold(fd, shell_fd);
+    return true;
+}
+
+static bool hold_all(scommand cmd, int saved[REDIR_FDS]) {
+    // guarda todas las redirecciones de `cmd'; con `saved', antes de tocar
+    // un descriptor se aparta lo que tenía, para redir_pop()
+    bool ok = true;
+    for (unsigned int n = 0; n < 2 + scommand_fdredir_count(cmd); n++) {
+        int fd = (int)n;
+        fdredir_t kind = n == 0 ? FDREDIR_READ : FDREDIR_WRITE;
+        char *target = n == 0 ? scommand_get_redir_in(cmd) : scommand_get_redir_out(cmd);
+        if (n >= 2) {
+            kind = scommand_get_fdredir(cmd, n - 2, &fd, &target);
+        }
+        if (target == NULL) {
+            continue;
+        }
+        if (saved != NULL && saved[fd] == REDIR_UNTOUCHED) {
+            saved[fd] = held[fd];
+            if (held[fd] >= 0) {
+                held[fd] = -1; // apartado, no cerrado
+                nheld--;
+            }
+        }
+        ok = exec_one(fd, kind, target) && ok;
+    }
+    return ok;
+}
+
+int redir_exec(scommand cmd) {
+    assert(cmd != NULL && !strcmp(scommand_front(cmd), "exec"));
+    scommand_pop_front(cmd); // Quita "exec"
+    if (!scommand_is_empty(cmd)) {
+        fprintf(stderr, "exec: sólo se admiten redirecciones (exec 3>archivo, exec 3>&-)\n");
+        return EXIT_FAILURE;
+    }
+    return hold_all(cmd, NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool redir_push(scommand cmd, int saved[REDIR_FDS]) {
+    assert(cmd != NULL && saved != NULL);
+    for (int fd = 0; fd < REDIR_FDS; fd++) {
+        saved[fd] = REDIR_UNTOUCHED;
+    }
+    bool ok = hold_all(cmd, saved);
+    if (!ok) {
+        redir_pop(saved);
+    }
+    return ok;
+}
+
+void redir_pop(int saved[REDIR_FDS]) {
+    assert(saved != NULL);
+    for (int fd = 0; fd < REDIR_FDS; fd++) {
+        if (saved[fd] != REDIR_UNTOUCHED) {
+            hold(fd, saved[fd]);
+        }
+    }
+}
+
+int redir_adopt(int shell_fd) {
+    assert(shell_fd >= 0);
+    int fd = REDIR_FDS - 1;
+    while (fd > 2 && held[fd] >= 0) { // 0, 1 y 2 no se toman nunca
+        fd--;
+    }
+    int high = fd > 2 ? fcntl(shell_fd, F_DUPFD_CLOEXEC, REDIR_FDS) : -1;
+    close(shell_fd);
+    if (high < 0) {
+        return -1;
+    }
+    hold(fd, high);
+    hidden[fd] = true;
+    return fd;
+}
+
+void redir_close(int fd) {
+    assert(fd >= 0 && fd < REDIR_FDS);
+    hold(fd, -1);
+}
+
+int redir_fd(int fd) {
+    return fd >= 0 && fd < REDIR_FDS && held[fd] >= 0 ? held[fd] : fd;
+}
+
+bool redir_pending(scommand cmd) {
+    assert(cmd != NULL);
+    if (scommand_fdredir_count(cmd) > 0) {
+        return true;
+    }
+    for (int fd = 0; fd < REDIR_FDS && nheld > 0; fd++) {
+        if (held[fd] >= 0 && !hidden[fd]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool names_fd(scommand cmd, int wanted) { // cmd tiene una redirección N>&wanted
+    for (unsigned int n = 0; n < scommand_fdredir_count(cmd); n++) {
+        int fd, source;
+        char *target;
+        if (scommand_get_fdredir(cmd, n, &fd, &target) == FDREDIR_DUP && parse_fd(target, &source) &&
+            source == wanted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void redir_inherit(scommand cmd) {
+    // después del dup2 la tabla se vacía: si el hijo corre un grupo, sus
+    // comandos heredan los descriptores ya puestos (y los pipes del hijo)
+    for (int fd = 0; fd < REDIR_FDS && nheld > 0; fd++) {
+        if (held[fd] >= 0) {
+            if (!hidden[fd] || names_fd(cmd, fd)) {
+                dup2(held[fd], fd); // la copia no tiene close-on-exec
+            }
+            hold(fd, -1);
+        }
+    }
+}
+
+bool redir_apply(scommand cmd) {
+    assert(cmd != NULL);
+    for (unsigned int n = 0; n < scommand_fdredir_count(cmd); n++) {
+        int fd;
+        char *target;
+        fdredir_t kind = scommand_get_fdredir(cmd, n, &fd, &target);
+        if (kind == FDREDIR_DUP && !strcmp(target, "-")) {
+            close(fd);
+            continue;
+        }
+        int source;
+        if (kind == FDREDIR_DUP) {
+            if (!parse_fd(target, &source)) {
+                fprintf(stderr, "%d>&%s: descriptor inválido\n", fd, target);
+                return false;
+            }
+        } else {
+            source = open(target, open_flags(kind), 0666);
+            if (source < 0) {
+                fprintf(stderr, "Error al abrir archivo '%s': %s\n", target, strerror(errno));
+                return false;
+            }
+        }
+        if (source != fd && dup2(source, fd) < 0) {
+            fprintf(stderr, "Error al redirigir el descriptor %d: %s\n", fd, strerror(errno));
+            return false;
+        }
+        if (kind != FDREDIR_DUP && source != fd) {
+            close(source);
+        }
+    }
+    return true;
+}
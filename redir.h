@@ -0,0 +1,101 @@
+/* Descriptores abiertos con `exec' y redirecciones de descriptores.
+ *
+ * `exec 3>log' abre el archivo una sola vez y el shell lo guarda en un
+ * descriptor propio alto (con close-on-exec, para no pisar ni filtrar los
+ * suyos). Cada comando que se lanza después lo recibe con dup2() como su
+ * descriptor 3, así que muchos comandos escriben por el mismo archivo
+ * abierto, uno detrás de otro, en lugar de abrirlo (y truncarlo) cada uno.
+ * Lo mismo vale para 0, 1 y 2: `exec 1>log' cambia la salida de los
+ * comandos, no la del shell.
+ */
+
+#ifndef _REDIR_H_
+#define _REDIR_H_
+
+#include <stdbool.h>
+#include "command.h"
+
+#define REDIR_FDS 10 // descriptores que se pueden redirigir: 0 a 9
+#define REDIR_UNTOUCHED (-2) // en el arreglo de redir_push(): descriptor sin cambios
+
+int redir_exec(scommand cmd);
+/*
+ * El comando interno exec: abre (o cierra, con N>&-) los descriptores de
+ * las redirecciones de `cmd' y los guarda para los comandos siguientes.
+ * `< archivo' y `> archivo' valen como 0< y 1>. Devuelve el estado.
+ *
+ * REQUIRES: cmd != NULL && !strcmp(scommand_front(cmd), "exec")
+ */
+
+bool redir_push(scommand cmd, int saved[REDIR_FDS]);
+/*
+ * Como exec, pero hasta redir_pop(): aplica las redirecciones de `cmd' (un
+ * grupo { ...; } > archivo que corre en el shell) a los comandos que se
+ * lancen mientras tanto, y aparta en `saved' lo que había guardado. Si
+ * alguna falla, deshace las demás y devuelve false.
+ *
+ * REQUIRES: cmd != NULL && saved != NULL
+ */
+
+void redir_pop(int saved[REDIR_FDS]);
+/*
+ * Cierra lo que abrió redir_push() y vuelve a poner lo apartado en `saved'.
+ *
+ * REQUIRES: saved != NULL
+ */
+
+int redir_adopt(int shell_fd);
+/*
+ * Guarda `shell_fd' (un extremo de un pipe del shell, p.ej. de un
+ * coproceso) como el descriptor libre más alto, entre 3 y 9, y lo
+ * devuelve. A diferencia de los de exec, un comando lo recibe sólo si lo
+ * usa en una redirección (`>&N'); read -u y mapfile -u lo leen igual. `shell_fd' queda cerrado; si no
+ * hay ninguno libre devuelve -1.
+ *
+ * REQUIRES: shell_fd >= 0
+ */
+
+void redir_close(int fd);
+/*
+ * Cierra lo guardado para `fd', como `exec N>&-'.
+ *
+ * REQUIRES: fd >= 0 && fd < REDIR_FDS
+ */
+
+int redir_fd(int fd);
+/*
+ * Descriptor del que tiene que leer el shell para leer "del descriptor
+ * `fd'" (read -u, mapfile -u): el que guardó exec, o el mismo `fd'.
+ */
+
+bool redir_pending(scommand cmd);
+/*
+ * Indica si lanzar `cmd' necesita redir_inherit() o redir_apply(): hay
+ * descriptores guardados por exec o `cmd' tiene redirecciones de
+ * descriptores. Un comando así no se puede lanzar desde el pool de zygotes.
+ * Los guardados con redir_adopt() no cuentan.
+ *
+ * REQUIRES: cmd != NULL
+ */
+
+void redir_inherit(scommand cmd);
+/*
+ * En un proceso hijo, antes de conectar pipes y redirecciones: pone los
+ * descriptores guardados por exec en su número y vacía la tabla. Los de
+ * redir_adopt() sólo si `cmd' los nombra en una redirección N>&M; si no,
+ * se cierran (un coproceso no ve la entrada de otro, que así recibe el fin
+ * de archivo cuando el shell la cierra).
+ *
+ * REQUIRES: cmd != NULL
+ */
+
+bool redir_apply(scommand cmd);
+/*
+ * En un proceso hijo, después de las redirecciones de archivo: aplica las
+ * redirecciones de descriptores de `cmd' en orden. Si alguna falla lo
+ * informa por stderr y devuelve false.
+ *
+ * REQUIRES: cmd != NULL
+ */
+
+#endif
@@ -0,0 +1,172 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "runner.h"
+#include "execute.h"
+#include "flow.h"
+#include "metrics.h"
+#include "strextra.h"
+#include "vars.h"
+
+#define RUNNER_COPY_BLOCK (64 * 1024)
+
+struct script_s {
+    const char *path;
+    pid_t pid;          // 0: todavía no empezó
+    FILE *out;          // su stdout y stderr
+    uint64_t start;
+    uint64_t elapsed;
+    int status;
+    bool done;
+};
+
+static int run_script(const char *path, runner_line_fn run_line) {
+    // en el hijo: las líneas del script, juntando las de un bloque abierto
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "mybash: %s: %s\n", path, strerror(errno));
+        return 127;
+    }
+    char *buf = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    char *pending = NULL;
+    while ((len = getline(&buf, &cap, file)) >= 0) {
+        if (len > 0 && buf[len - 1] == '\n') {
+            buf[len - 1] = '\0';
+        }
+        if (buf[strspn(buf, " \t")] == '#') { // comentario o #!
+            continue;
+        }
+        if (pending == NULL) {
+            pending = strdup(buf);
+        } else {
+            char *tmp = strmerge(pending, "\n");
+            free(pending);
+            pending = strmerge(tmp, buf);
+            free(tmp);
+        }
+        if (!flow_incomplete(pending)) {
+            execute_reap();
+            run_line(pending);
+            pending = NULL;
+        }
+    }
+    if (pending != NULL) { // un bloque sin cerrar: que lo informe el parser
+        run_line(pending);
+    }
+    free(buf);
+    fclose(file);
+    return vars_get_status();
+}
+
+static bool start(struct script_s *s, runner_line_fn run_line) {
+    s->out = tmpfile();
+    if (s->out == NULL) {
+        fprintf(stderr, "mybash: %s: archivo temporal: %s\n", s->path, strerror(errno));
+        return false;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    s->start = metrics_now();
+    s->pid = fork();
+    if (s->pid < 0) {
+        perror("fork");
+        fclose(s->out);
+        s->out = NULL;
+        return false;
+    }
+    if (s->pid == 0) {
+        int null = open("/dev/null", O_RDONLY);
+        if (null < 0 || dup2(null, STDIN_FILENO) < 0 || dup2(fileno(s->out), STDOUT_FILENO) < 0 ||
+            dup2(fileno(s->out), STDERR_FILENO) < 0) {
+            perror("mybash");
+            _exit(126);
+        }
+        close(null);
+        exit(run_script(s->path, run_line)); // exit(): vacía stdout
+    }
+    return true;
+}
+
+static void copy_output(FILE *out) {
+    // la salida guardada de un script, a la salida del runner
+    char *block = malloc(RUNNER_COPY_BLOCK);
+    off_t offset = 0;
+    ssize_t r;
+    while ((r = pread(fileno(out), block, RUNNER_COPY_BLOCK, offset)) > 0) {
+        for (ssize_t done = 0; done < r;) {
+            ssize_t w = write(STDOUT_FILENO, block + done, (size_t)(r - done));
+            if (w < 0 && errno != EINTR) {
+                free(block);
+                return;
+            }
+            done += w > 0 ? w : 0;
+        }
+        offset += r;
+    }
+    free(block);
+}
+
+int runner_run(unsigned int jobs, char **scripts, unsigned int n, runner_line_fn run_line) {
+    assert(jobs > 0 && scripts != NULL && run_line != NULL);
+    struct script_s *all = calloc(n, sizeof(struct script_s));
+    unsigned int next = 0;      // próximo a lanzar
+    unsigned int shown = 0;     // próximo a mostrar
+    unsigned int running = 0;
+    unsigned int failed = 0;
+    uint64_t begin = metrics_now();
+    for (unsigned int i = 0; i < n; i++) {
+        all[i].path = scripts[i];
+    }
+    while (shown < n) {
+        while (running < jobs && next < n) {
+            struct script_s *s = &all[next++];
+            if (start(s, run_line)) {
+                running++;
+            } else {
+                s->status = 126;
+                s->done = true;
+            }
+        }
+        while (shown < n && all[shown].done) { // en orden: los que ya terminaron, hasta el primero que no
+            struct script_s *s = &all[shown++];
+            if (s->out != NULL) {
+                copy_output(s->out);
+                fclose(s->out);
+            }
+            fprintf(stderr, "== %s: estado %d, %.3f s\n", s->path, s->status, (double)s->elapsed / 1e9);
+            failed += s->status != 0;
+        }
+        if (running == 0) {
+            continue;
+        }
+        int raw;
+        pid_t pid = waitpid(-1, &raw, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("waitpid");
+            break;
+        }
+        for (unsigned int i = 0; i < next; i++) {
+            if (all[i].pid == pid && !all[i].done) {
+                all[i].elapsed = metrics_now() - all[i].start;
+                all[i].status = WIFEXITED(raw) ? WEXITSTATUS(raw) : 128 + WTERMSIG(raw);
+                all[i].done = true;
+                running--;
+            }
+        }
+    }
+    fprintf(stderr, "== %u scripts, %u con error, %.3f s (-P %u)\n", n, failed,
+            (double)(metrics_now() - begin) / 1e9, jobs);
+    free(all);
+    return failed > 0 ? 1 : 0;
+}
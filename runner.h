@@ -0,0 +1,30 @@
+/* Ejecución de muchos scripts en paralelo (`mybash -P N a.sh b.sh ...').
+ *
+ * Cada script corre en un proceso propio, hijo directo del shell ya
+ * iniciado: no se vuelve a cargar el binario ni a leer el entorno, el fork
+ * comparte todo eso (copy-on-write) y cada script tiene igual su propio
+ * directorio, variables, funciones y descriptores. Como mucho N corren a
+ * la vez. La entrada de cada uno es /dev/null y su salida (stdout y
+ * stderr) va a un archivo temporal, que se copia a la salida del runner en
+ * el orden de los scripts, apenas terminan él y los anteriores; después de
+ * cada uno, en stderr, una línea con su estado y cuánto tardó.
+ *
+ * Los scripts se leen de a una línea, como `mybash < script', salvo que
+ * las líneas que empiezan con `#' (p.ej. #!/usr/bin/mybash) se saltean.
+ */
+
+#ifndef _RUNNER_H_
+#define _RUNNER_H_
+
+typedef int (*runner_line_fn)(char *line);
+
+int runner_run(unsigned int jobs, char **scripts, unsigned int n, runner_line_fn run_line);
+/*
+ * Ejecuta los `n' scripts de `scripts' con a lo sumo `jobs' a la vez; cada
+ * línea (o bloque) se ejecuta con `run_line', que la libera. Devuelve 0 si
+ * todos terminaron con estado 0, 1 si no.
+ *
+ * REQUIRES: jobs > 0 && scripts != NULL && run_line != NULL
+ */
+
+#endif
@@ -0,0 +1,298 @@
+#define _GNU_SOURCE     /* MSG_CMSG_CLOEXEC, SOCK_CLOEXEC */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "server.h"
+#include "command.h"
+#include "execute.h"
+#include "parsing.h"
+#include "plan.h"
+#include "builtin.h"
+#include "metrics.h"
+
+#define MAX_REQUEST (64 * 1024)     // largo máximo de una línea de comandos
+#define MAX_EVENTS 64
+#define STDIO_FDS 3                 // entrada, salida y error
+
+struct client_s {
+    int fd;
+    char *buf;                      // pedido que se está recibiendo
+    size_t len;
+    int stdio[STDIO_FDS];           // descriptores recibidos para el pedido (-1 si no)
+    pid_t running;                  // hijo que ejecuta el pedido en curso (0 si no hay)
+    struct client_s *next;
+};
+
+static struct client_s *clients = NULL;
+static int listen_fd = -1;
+static int epoll_fd = -1;
+static int signal_fd = -1;
+
+static void stdio_close(struct client_s *c) {
+    for (int i = 0; i < STDIO_FDS; i++) {
+        if (c->stdio[i] >= 0) {
+            close(c->stdio[i]);
+            c->stdio[i] = -1;
+        }
+    }
+}
+
+static void client_drop(struct client_s *c) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    stdio_close(c);
+    free(c->buf);
+    c->fd = -1;
+    if (c->running == 0) { // si tiene un pedido en curso se libera al terminar
+        for (struct client_s **p = &clients; *p != NULL; p = &(*p)->next) {
+            if (*p == c) {
+                *p = c->next;
+                break;
+            }
+        }
+        free(c);
+    }
+}
+
+static void client_accept(void) {
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct client_s *c = calloc(1, sizeof(struct client_s));
+    c->fd = fd;
+    c->buf = malloc(sizeof(uint32_t) + MAX_REQUEST + 1); // + el '\0' del final
+    for (int i = 0; i < STDIO_FDS; i++) {
+        c->stdio[i] = -1;
+    }
+    c->next = clients;
+    clients = c;
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void child_stdio(struct client_s *c) {
+    // en el hijo: los descriptores del cliente pasan a ser 0, 1 y 2
+    int devnull = open("/dev/null", O_RDWR);
+    for (int i = 0; i < STDIO_FDS; i++) {
+        int src = c->stdio[i] >= 0 ? c->stdio[i] : devnull;
+        if (src >= 0 && dup2(src, i) < 0) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+    if (devnull > STDERR_FILENO) {
+        close(devnull);
+    }
+}
+
+static void client_execute(struct client_s *c, const char *line) {
+    uint64_t parse_start = metrics_now();
+    pipeline pipe = parse_pipeline_from_string(line);
+    metrics_observe(METRIC_PARSE, parse_start);
+    if (pipe == NULL) {
+        int32_t status = 2; // error de sintaxis
+        send(c->fd, &status, sizeof(status), MSG_NOSIGNAL);
+        stdio_close(c);
+        return;
+    }
+    plan_pipeline(pipe);
+    metrics_count(builtin_alone(pipe) ? METRIC_BUILTIN : METRIC_EXTERNAL);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        int32_t status = EXIT_FAILURE;
+        send(c->fd, &status, sizeof(status), MSG_NOSIGNAL);
+    } else if (pid == 0) { // hijo: ejecuta con los descriptores del cliente
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, NULL);
+        child_stdio(c);
+        for (struct client_s *o = clients; o != NULL; o = o->next) { // no retener conexiones
+            if (o->fd >= 0) {
+                close(o->fd);
+            }
+            stdio_close(o);
+        }
+        close(listen_fd);
+        close(epoll_fd);
+        close(signal_fd);
+        _exit(execute_pipeline(pipe));
+    } else {
+        c->running = pid;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL); // no leer más hasta responder
+    }
+    pipeline_destroy(pipe);
+    stdio_close(c);
+}
+
+static void take_fds(struct client_s *c, struct msghdr *msg) {
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t n = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int *fds = (int *)CMSG_DATA(cm);
+        for (size_t i = 0; i < n; i++) {
+            if (i < STDIO_FDS && c->stdio[i] < 0) {
+                c->stdio[i] = fds[i];
+            } else {
+                close(fds[i]); // sobran
+            }
+        }
+    }
+}
+
+static void client_read(struct client_s *c) {
+    for (;;) {
+        size_t want = sizeof(uint32_t); // primero el largo, después la línea
+        if (c->len >= sizeof(uint32_t)) {
+            uint32_t n;
+            memcpy(&n, c->buf, sizeof(n));
+            if (n > MAX_REQUEST) {
+                client_drop(c);
+                return;
+            }
+            want += n;
+        }
+        if (c->len == want && want > sizeof(uint32_t)) { // pedido completo
+            c->buf[c->len] = '\0';
+            c->len = 0;
+            client_execute(c, c->buf + sizeof(uint32_t));
+            return;
+        }
+        if (c->len == want) { // largo 0: nada que ejecutar
+            int32_t status = 0;
+            send(c->fd, &status, sizeof(status), MSG_NOSIGNAL);
+            c->len = 0;
+            continue;
+        }
+
+        char cbuf[CMSG_SPACE(STDIO_FDS * sizeof(int))];
+        struct iovec iov = {.iov_base = c->buf + c->len, .iov_len = want - c->len};
+        struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1,
+                             .msg_control = cbuf, .msg_controllen = sizeof(cbuf)};
+        ssize_t r = recvmsg(c->fd, &msg, MSG_CMSG_CLOEXEC);
+        if (r < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return;
+        }
+        if (r <= 0) {
+            client_drop(c);
+            return;
+        }
+        take_fds(c, &msg);
+        c->len += (size_t)r;
+    }
+}
+
+static bool drain_signals(void) {
+    // lee todas las señales pendientes; true si alguna pide terminar
+    struct signalfd_siginfo info;
+    bool quit = false;
+    while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        if (info.ssi_signo != SIGCHLD) {
+            quit = true;
+        }
+    }
+    return quit;
+}
+
+static void reap_children(void) {
+    int raw;
+    pid_t pid;
+    while ((pid = waitpid(-1, &raw, WNOHANG)) > 0) {
+        for (struct client_s *c = clients; c != NULL; c = c->next) {
+            if (c->running != pid) {
+                continue;
+            }
+            c->running = 0;
+            if (c->fd < 0) { // el cliente ya se fue
+                client_drop(c);
+                break;
+            }
+            int32_t status = WIFEXITED(raw) ? WEXITSTATUS(raw) : 128 + WTERMSIG(raw);
+            send(c->fd, &status, sizeof(status), MSG_NOSIGNAL);
+            struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+            client_read(c); // puede haber otro pedido esperando
+            break;
+        }
+    }
+}
+
+int server_run(const char *socket_path) {
+    assert(socket_path != NULL);
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "mybash: %s: camino del socket demasiado largo\n", socket_path);
+        return EXIT_FAILURE;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socket_path);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, SOMAXCONN) < 0) {
+        perror("mybash: server");
+        return EXIT_FAILURE;
+    }
+
+    // SIGCHLD, SIGINT y SIGTERM se atienden en el bucle a través de signalfd
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.ptr = &signal_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev);
+
+    bool quit = false;
+    while (!quit) {
+        struct epoll_event events[MAX_EVENTS];
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, metrics_tick()); // despierta para exportar métricas
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                client_accept();
+            } else if (events[i].data.ptr == &signal_fd) {
+                quit = drain_signals() || quit;
+                reap_children();
+            } else {
+                client_read(events[i].data.ptr);
+            }
+        }
+    }
+
+    while (clients != NULL) { // los pedidos en curso siguen; sólo se cierran las conexiones
+        struct client_s *c = clients;
+        clients = c->next;
+        if (c->fd >= 0) {
+            close(c->fd);
+        }
+        stdio_close(c);
+        free(c->buf);
+        free(c);
+    }
+    close(listen_fd);
+    close(epoll_fd);
+    close(signal_fd);
+    unlink(socket_path);
+    return EXIT_SUCCESS;
+}
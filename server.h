@@ -0,0 +1,35 @@
+/* Modo servidor: `mybash --server /camino/al/socket'.
+ *
+ * El shell queda escuchando en un socket Unix de tipo stream y ejecuta las
+ * líneas de comandos que le mandan los clientes, sin tener que arrancar un
+ * proceso mybash por cada una. Un único bucle de eventos (epoll) atiende a
+ * todos los clientes a la vez.
+ *
+ * Protocolo (enteros de 32 bits en el orden de bytes de la máquina):
+ *
+ *   pedido:    uint32 largo  |  `largo' bytes con la línea de comandos
+ *   respuesta: int32 estado
+ *
+ * Junto con los primeros bytes de un pedido el cliente puede mandar, como
+ * datos auxiliares SCM_RIGHTS, tres descriptores que se usarán como
+ * entrada, salida y error estándar del pipeline; si no manda ninguno se usa
+ * /dev/null. El estado es el de execute_pipeline(), o 2 si la línea tiene un
+ * error de sintaxis. Cada cliente puede tener un pedido en curso a la vez;
+ * los siguientes esperan a que se responda el anterior.
+ */
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+int server_run(const char *socket_path);
+/*
+ * Atiende clientes en `socket_path' hasta recibir SIGINT o SIGTERM.
+ * Cada línea se parsea en el servidor y se ejecuta en un proceso hijo, por
+ * lo que los comandos internos (cd, export, ...) no afectan a los pedidos
+ * siguientes.
+ * Devuelve el estado de salida del servidor.
+ *
+ * REQUIRES: socket_path != NULL
+ */
+
+#endif
@@ -0,0 +1,198 @@
+#include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vars.h"
+
+struct var_s {
+    char *name;
+    char *value;    // NULL si sólo está marcada para exportar
+    bool exported;
+};
+
+static struct var_s *vars = NULL;   // tabla de variables
+static size_t vars_len = 0;
+static size_t vars_cap = 0;
+
+static int last_status = 0;         // valor de $?
+static char **args = NULL;          // parámetros posicionales $1, $2, ... (los de la función en curso)
+static unsigned int args_len = 0;   // valor de $#
+
+static char **envp_cache = NULL;    // entorno armado para execve()
+static bool envp_dirty = true;      // hay que volver a armarlo
+
+static struct var_s *vars_find(const char *name) {
+    for (size_t i = 0; i < vars_len; i++) {
+        if (!strcmp(vars[i].name, name)) {
+            return &vars[i];
+        }
+    }
+    return NULL;
+}
+
+static struct var_s *vars_find_or_add(const char *name) {
+    struct var_s *v = vars_find(name);
+    if (v == NULL) {
+        if (vars_len == vars_cap) {
+            vars_cap = vars_cap == 0 ? 64 : 2 * vars_cap;
+            vars = realloc(vars, vars_cap * sizeof(struct var_s));
+        }
+        v = &vars[vars_len++];
+        v->name = strdup(name);
+        v->value = NULL;
+        v->exported = false;
+    }
+    return v;
+}
+
+bool vars_valid_name(const char *name, size_t len) {
+    assert(name != NULL);
+    if (len == 0 || isdigit((unsigned char)name[0])) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool vars_is_assignment(const char *word) {
+    assert(word != NULL);
+    const char *eq = strchr(word, '=');
+    return eq != NULL && vars_valid_name(word, (size_t)(eq - word));
+}
+
+void vars_init(char **envp) {
+    assert(envp != NULL);
+    for (size_t i = 0; envp[i] != NULL; i++) {
+        const char *eq = strchr(envp[i], '=');
+        if (eq == NULL || !vars_valid_name(envp[i], (size_t)(eq - envp[i]))) {
+            continue; // se ignoran entradas que no son variables válidas
+        }
+        char *name = strndup(envp[i], (size_t)(eq - envp[i]));
+        vars_set(name, eq + 1);
+        vars_export(name);
+        free(name);
+    }
+}
+
+const char *vars_get(const char *name) {
+    assert(name != NULL);
+    struct var_s *v = vars_find(name);
+    return v != NULL ? v->value : NULL;
+}
+
+void vars_set(const char *name, const char *value) {
+    assert(name != NULL && value != NULL);
+    struct var_s *v = vars_find_or_add(name);
+    free(v->value);
+    v->value = strdup(value);
+    if (v->exported) {
+        envp_dirty = true; // sólo las exportadas afectan al entorno
+    }
+}
+
+void vars_export(const char *name) {
+    assert(name != NULL);
+    struct var_s *v = vars_find_or_add(name);
+    if (!v->exported) {
+        v->exported = true;
+        envp_dirty = true;
+    }
+}
+
+void vars_unset(const char *name) {
+    assert(name != NULL);
+    struct var_s *v = vars_find(name);
+    if (v == NULL) {
+        return;
+    }
+    if (v->exported) {
+        envp_dirty = true;
+    }
+    free(v->name);
+    free(v->value);
+    *v = vars[--vars_len]; // el orden de la tabla no importa
+}
+
+static void envp_free(char **envp) {
+    if (envp != NULL) {
+        for (size_t i = 0; envp[i] != NULL; i++) {
+            free(envp[i]);
+        }
+        free(envp);
+    }
+}
+
+char **vars_envp(void) {
+    if (!envp_dirty && envp_cache != NULL) {
+        return envp_cache; // caso común: el entorno no cambió
+    }
+
+    size_t n = 0;
+    char **envp = malloc((vars_len + 1) * sizeof(char *));
+    for (size_t i = 0; i < vars_len; i++) {
+        if (vars[i].exported && vars[i].value != NULL) {
+            size_t len = strlen(vars[i].name) + strlen(vars[i].value) + 2;
+            envp[n] = malloc(len);
+            snprintf(envp[n], len, "%s=%s", vars[i].name, vars[i].value);
+            n++;
+        }
+    }
+    envp[n] = NULL;
+
+    envp_free(envp_cache);
+    envp_cache = envp;
+    envp_dirty = false;
+    return envp_cache;
+}
+
+void vars_set_status(int status) {
+    last_status = status;
+}
+
+int vars_get_status(void) {
+    return last_status;
+}
+
+char **vars_swap_args(char **new_args) {
+    char **old = args;
+    args = new_args;
+    args_len = 0;
+    while (args != NULL && args[args_len] != NULL) {
+        args_len++;
+    }
+    return old;
+}
+
+void vars_set_args(char **new_args) {
+    char **old = vars_swap_args(new_args);
+    for (unsigned int i = 0; old != NULL && old[i] != NULL; i++) {
+        free(old[i]);
+    }
+    free(old);
+}
+
+const char *vars_get_arg(unsigned int n) {
+    assert(n > 0);
+    return n <= args_len ? args[n - 1] : NULL;
+}
+
+unsigned int vars_arg_count(void) {
+    return args_len;
+}
+
+void vars_print_exported(void) {
+    for (size_t i = 0; i < vars_len; i++) {
+        if (vars[i].exported) {
+            if (vars[i].value != NULL) {
+                printf("export %s=%s\n", vars[i].name, vars[i].value);
+            } else {
+                printf("export %s\n", vars[i].name);
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/* Variables del shell y entorno de los comandos externos.
+ *
+ * Las variables marcadas para exportar forman el entorno (envp) que reciben
+ * los comandos. Ese arreglo se arma una sola vez y se vuelve a armar sólo
+ * cuando cambia alguna variable exportada, por lo que lanzar un comando con
+ * el entorno sin cambios no cuesta nada extra.
+ */
+
+#ifndef _VARS_H_
+#define _VARS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+void vars_init(char **envp);
+/*
+ * Carga como variables exportadas todas las cadenas "NOMBRE=valor" de
+ * `envp' (el entorno que recibió el shell).
+ *
+ * REQUIRES: envp != NULL
+ */
+
+const char *vars_get(const char *name);
+/*
+ * Devuelve el valor de la variable `name', o NULL si no está definida.
+ * La cadena sigue siendo propiedad del módulo y deja de ser válida si la
+ * variable se modifica.
+ *
+ * REQUIRES: name != NULL
+ */
+
+void vars_set(const char *name, const char *value);
+/*
+ * Define (o redefine) la variable `name' con una copia de `value'. Si la
+ * variable ya estaba exportada, lo sigue estando.
+ *
+ * REQUIRES: vars_valid_name(name, strlen(name)) && value != NULL
+ */
+
+void vars_export(const char *name);
+/*
+ * Marca la variable `name' para que forme parte del entorno de los comandos.
+ * Si no estaba definida, queda marcada y se exporta cuando se le dé valor.
+ *
+ * REQUIRES: vars_valid_name(name, strlen(name))
+ */
+
+void vars_unset(const char *name);
+/*
+ * Elimina la variable `name' (y la quita del entorno si estaba exportada).
+ *
+ * REQUIRES: name != NULL
+ */
+
+char **vars_envp(void);
+/*
+ * Devuelve el entorno para execve(): un arreglo terminado en NULL con las
+ * cadenas "NOMBRE=valor" de las variables exportadas. Es propiedad del
+ * módulo y deja de ser válido al modificar una variable exportada.
+ */
+
+void vars_print_exported(void);
+/*
+ * Muestra por stdout las variables exportadas, como `export NOMBRE=valor'.
+ */
+
+void vars_set_status(int status);
+int vars_get_status(void);
+/*
+ * Guarda (consulta) el estado de salida del último pipeline, el valor de $?.
+ */
+
+char **vars_swap_args(char **args);
+/*
+ * Reemplaza los parámetros posicionales ($1, $2, ...) por `args', un
+ * arreglo de cadenas nuevas terminado en NULL, y devuelve los anteriores
+ * para restaurarlos. `args' pasa a ser del módulo y lo devuelto, del
+ * llamador. Con NULL no hay parámetros.
+ */
+
+void vars_set_args(char **args);
+/*
+ * Como vars_swap_args(), pero libera los parámetros anteriores.
+ */
+
+const char *vars_get_arg(unsigned int n);
+unsigned int vars_arg_count(void);
+/*
+ * Consulta el parámetro posicional $n (NULL si no hay tantos) y la
+ * cantidad de parámetros, el valor de $#.
+ *
+ * REQUIRES: n > 0
+ */
+
+bool vars_valid_name(const char *name, size_t len);
+/*
+ * Indica si los primeros `len' caracteres de `name' forman un nombre de
+ * variable válido: letras, dígitos y '_', sin empezar con un dígito.
+ *
+ * REQUIRES: name != NULL
+ */
+
+bool vars_is_assignment(const char *word);
+/*
+ * Indica si `word' tiene la forma NOMBRE=valor.
+ *
+ * REQUIRES: word != NULL
+ */
+
+#endif
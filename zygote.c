@@ -0,0 +1,390 @@
+#define _GNU_SOURCE     /* execvpe(), close_range(), environ */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "zygote.h"
+#include "options.h"
+#include "vars.h"
+
+#define ZYGOTE_POOL 4                   // procesos que se mantienen listos
+#define ZYGOTE_MAX_MSG (64 * 1024)      // pedidos más grandes se lanzan con fork
+#define ZYGOTE_SOCK 3                   // socket de control en el maestro, propio en un zygote
+
+// Encabezado de un pedido; le siguen las cadenas terminadas en '\0':
+// directorio actual, cgroup, redirección de entrada, de salida, argv y entorno
+struct request_s {
+    uint32_t argc;
+    uint32_t envc;
+    pid_t pgid;                         // grupo del pipeline (-1: el del shell)
+    bool foreground;
+    placement_t place;                  // sin los punteros, que no viajan
+};
+
+struct zygote_s {
+    pid_t pid;
+    int sock;                           // extremo del shell
+};
+
+static struct zygote_s pool[ZYGOTE_POOL];
+static unsigned int ready = 0;          // zygotes listos en `pool'
+static unsigned int pending = 0;        // zygotes pedidos al maestro y todavía no recibidos
+static pid_t master = 0;                // proceso que crea los zygotes
+static int master_sock = -1;
+static pid_t owner = 0;                 // proceso dueño del pool (0: sin pool)
+
+// Agrega la cadena `s' (o "" si es NULL) al pedido; false si no entra
+static bool put_string(char *buf, size_t *len, const char *s) {
+    size_t n = s != NULL ? strlen(s) + 1 : 1;
+    if (*len + n > ZYGOTE_MAX_MSG) {
+        return false;
+    }
+    memcpy(buf + *len, s != NULL ? s : "", n);
+    *len += n;
+    return true;
+}
+
+// Toma la siguiente cadena del pedido recibido
+static char *take_string(char **cursor) {
+    char *s = *cursor;
+    *cursor += strlen(s) + 1;
+    return s;
+}
+
+static void zygote_redirect(const char *path, int flags, int target) {
+    int fd = open(path, flags, 0666);
+    if (fd < 0) {
+        fprintf(stderr, "Error al abrir archivo %s '%s': %s\n",
+                target == STDIN_FILENO ? "de entrada" : "de salida", path, strerror(errno));
+        _exit(1);
+    }
+    if (dup2(fd, target) < 0) {
+        fprintf(stderr, "Error al redirigir '%s': %s\n", path, strerror(errno));
+        _exit(1);
+    }
+    close(fd);
+}
+
+// Cuerpo de un zygote: espera un pedido en ZYGOTE_SOCK y hace exec
+static void zygote_main(void) {
+    char *buf = malloc(ZYGOTE_MAX_MSG + 1);
+    char cbuf[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec iov = {.iov_base = buf, .iov_len = ZYGOTE_MAX_MSG};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1,
+                         .msg_control = cbuf, .msg_controllen = sizeof(cbuf)};
+    ssize_t r;
+    do {
+        r = recvmsg(ZYGOTE_SOCK, &msg, MSG_CMSG_CLOEXEC);
+    } while (r < 0 && errno == EINTR);
+    if (buf == NULL || r < (ssize_t)sizeof(struct request_s)) {
+        _exit(0); // el shell cerró el pool
+    }
+    buf[r] = '\0';
+
+    // entrada, salida y error del comando
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    if (cm == NULL || cm->cmsg_type != SCM_RIGHTS || cm->cmsg_len != CMSG_LEN(3 * sizeof(int))) {
+        _exit(1);
+    }
+    int fds[3];
+    memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+    for (int i = 0; i < 3; i++) {
+        if (dup2(fds[i], i) < 0) {
+            _exit(1);
+        }
+        close(fds[i]);
+    }
+
+    struct request_s req;
+    memcpy(&req, buf, sizeof(req));
+    char *cursor = buf + sizeof(req);
+    char *cwd = take_string(&cursor);
+    char *cgroup = take_string(&cursor);
+    char *redir_in = take_string(&cursor);
+    char *redir_out = take_string(&cursor);
+    placement_join_group(req.pgid, req.foreground);
+    req.place.cgroup = *cgroup != '\0' ? cgroup : NULL;
+    if (!placement_apply(&req.place)) {
+        _exit(1);
+    }
+    if (chdir(cwd) < 0) {
+        fprintf(stderr, "cd: cannot access '%s': %s\n", cwd, strerror(errno));
+        _exit(1);
+    }
+    if (*redir_in != '\0') {
+        zygote_redirect(redir_in, O_RDONLY, STDIN_FILENO);
+    }
+    if (*redir_out != '\0') {
+        zygote_redirect(redir_out, O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO);
+    }
+
+    char **argv = malloc((req.argc + 1) * sizeof(char *));
+    environ = malloc((req.envc + 1) * sizeof(char *));
+    for (uint32_t i = 0; i < req.argc; i++) {
+        argv[i] = take_string(&cursor);
+    }
+    argv[req.argc] = NULL;
+    for (uint32_t i = 0; i < req.envc; i++) {
+        environ[i] = take_string(&cursor);
+    }
+    environ[req.envc] = NULL;
+
+    // A=1 B=2 cmd: las asignaciones iniciales sólo valen para el comando
+    size_t skip = 0;
+    while (argv[skip] != NULL && argv[skip + 1] != NULL && vars_is_assignment(argv[skip])) {
+        putenv(argv[skip]);
+        ++skip;
+    }
+    signal(SIGINT, SIG_DFL); // el maestro las ignora, el comando no
+    signal(SIGQUIT, SIG_DFL);
+    execvpe(argv[skip], argv + skip, environ);
+    fprintf(stderr, "%s: comando no encontrado.\n", argv[skip]);
+    _exit(1);
+}
+
+// Cuerpo del maestro: por cada byte que llega crea un zygote y le devuelve
+// al shell su pid y su socket. Los zygotes se crean con CLONE_PARENT para
+// que sean hijos del shell y éste los pueda esperar con waitpid().
+static void master_main(void) {
+    for (;;) {
+        char c;
+        ssize_t r = recv(ZYGOTE_SOCK, &c, 1, 0);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            _exit(0); // el shell cerró el pool
+        }
+
+        int sv[2];
+        pid_t pid = -1;
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == 0) {
+            pid = (pid_t)syscall(SYS_clone, CLONE_PARENT | SIGCHLD, NULL, NULL, NULL, NULL);
+            if (pid == 0) { // zygote: su socket reemplaza al de control
+                if (dup3(sv[1], ZYGOTE_SOCK, O_CLOEXEC) < 0) {
+                    _exit(1);
+                }
+                close(sv[0]);
+                close(sv[1]);
+                zygote_main();
+            }
+            close(sv[1]);
+        }
+
+        // respuesta: el pid (-1 si falló) y, si hay zygote, su socket
+        char cbuf[CMSG_SPACE(sizeof(int))];
+        memset(cbuf, 0, sizeof(cbuf));
+        struct iovec iov = {.iov_base = &pid, .iov_len = sizeof(pid)};
+        struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1};
+        if (pid > 0) {
+            msg.msg_control = cbuf;
+            msg.msg_controllen = sizeof(cbuf);
+            struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+            cm->cmsg_level = SOL_SOCKET;
+            cm->cmsg_type = SCM_RIGHTS;
+            cm->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cm), &sv[0], sizeof(int));
+        }
+        sendmsg(ZYGOTE_SOCK, &msg, MSG_NOSIGNAL);
+        if (pid > 0) {
+            close(sv[0]);
+        }
+    }
+}
+
+// Lanza el maestro; queda chico porque sólo conserva su socket de control
+static bool master_start(void) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return false;
+    }
+    if (pid == 0) {
+        if (dup3(sv[1], ZYGOTE_SOCK, O_CLOEXEC) < 0) {
+            _exit(1);
+        }
+        close_range(ZYGOTE_SOCK + 1, ~0U, 0);
+        int devnull = open("/dev/null", O_RDWR); // no retener la terminal ni pipes ajenos
+        for (int i = 0; i < 3 && devnull >= 0; i++) {
+            dup2(devnull, i);
+        }
+        if (devnull > STDERR_FILENO) {
+            close(devnull);
+        }
+        signal(SIGINT, SIG_IGN); // Ctrl-C no debe vaciar el pool
+        signal(SIGQUIT, SIG_IGN);
+        master_main();
+    }
+    close(sv[1]);
+    master = pid;
+    master_sock = sv[0];
+    return true;
+}
+
+// Recibe los zygotes que el maestro ya entregó; con `block' espera todos
+static void collect(bool block) {
+    while (pending > 0) {
+        pid_t pid;
+        char cbuf[CMSG_SPACE(sizeof(int))];
+        struct iovec iov = {.iov_base = &pid, .iov_len = sizeof(pid)};
+        struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1,
+                             .msg_control = cbuf, .msg_controllen = sizeof(cbuf)};
+        ssize_t r = recvmsg(master_sock, &msg, MSG_CMSG_CLOEXEC | (block ? 0 : MSG_DONTWAIT));
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0 && errno == EAGAIN) {
+            return;
+        }
+        if (r != sizeof(pid)) { // el maestro murió
+            pending = 0;
+            return;
+        }
+        pending--;
+        struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+        if (pid > 0 && cm != NULL && cm->cmsg_type == SCM_RIGHTS) {
+            memcpy(&pool[ready].sock, CMSG_DATA(cm), sizeof(int));
+            pool[ready].pid = pid;
+            ready++;
+        }
+    }
+}
+
+// Pide al maestro los zygotes que faltan para completar el pool, sin esperarlos
+static void request(void) {
+    while (ready + pending < ZYGOTE_POOL) {
+        char c = 0;
+        if (send(master_sock, &c, 1, MSG_DONTWAIT | MSG_NOSIGNAL) != 1) {
+            return;
+        }
+        pending++;
+    }
+}
+
+// Cierra el pool; en un hijo del dueño sólo se sueltan los descriptores heredados
+static void zygote_release(void) {
+    bool mine = owner == getpid();
+    if (mine && master > 0) {
+        collect(true); // que no queden zygotes sin esperar
+    }
+    for (unsigned int i = 0; i < ready; i++) {
+        close(pool[i].sock); // el zygote recibe EOF y termina
+        if (mine) {
+            waitpid(pool[i].pid, NULL, 0);
+        }
+    }
+    ready = 0;
+    pending = 0;
+    if (master > 0) {
+        close(master_sock);
+        if (mine) {
+            waitpid(master, NULL, 0);
+        }
+        master = 0;
+        master_sock = -1;
+    }
+}
+
+void zygote_refill(void) {
+    if (owner == 0) {
+        owner = getpid();
+    } else if (owner != getpid()) { // somos un hijo del shell: el pool no es nuestro
+        zygote_release();
+        return;
+    }
+    if (!option_get(OPT_ZYGOTE)) {
+        zygote_release();
+        return;
+    }
+    if (master == 0 && !master_start()) {
+        return;
+    }
+    collect(false);
+    request();
+}
+
+pid_t zygote_spawn(scommand cmd, int in_fd, int out_fd, pid_t pgid, bool foreground,
+                   const placement_t *place) {
+    assert(cmd != NULL && !scommand_is_empty(cmd) && place != NULL);
+    if (owner != getpid()) {
+        zygote_release(); // pool heredado del shell: no es nuestro
+        return -1;
+    }
+    if (!option_get(OPT_ZYGOTE) || master == 0) {
+        return -1;
+    }
+    collect(false);
+    if (ready == 0) {
+        request();
+        return -1;
+    }
+
+    // armar el pedido
+    char *cwd = getcwd(NULL, 0);
+    char **envp = vars_envp();
+    struct request_s req = {.argc = scommand_length(cmd), .envc = 0,
+                            .pgid = pgid, .foreground = foreground, .place = *place};
+    req.place.cgroup = NULL;
+    req.place.spec = NULL;
+    while (envp[req.envc] != NULL) {
+        req.envc++;
+    }
+    char *buf = malloc(ZYGOTE_MAX_MSG);
+    size_t len = sizeof(req);
+    memcpy(buf, &req, sizeof(req));
+    bool fits = cwd != NULL && put_string(buf, &len, cwd) &&
+                put_string(buf, &len, place->cgroup) &&
+                put_string(buf, &len, scommand_get_redir_in(cmd)) &&
+                put_string(buf, &len, scommand_get_redir_out(cmd));
+    for (uint32_t i = 0; i < req.argc && fits; i++) {
+        fits = put_string(buf, &len, scommand_nth(cmd, i));
+    }
+    for (uint32_t i = 0; i < req.envc && fits; i++) {
+        fits = put_string(buf, &len, envp[i]);
+    }
+    free(cwd);
+    if (!fits) {
+        free(buf);
+        return -1;
+    }
+
+    int fds[3] = {in_fd >= 0 ? in_fd : STDIN_FILENO, out_fd >= 0 ? out_fd : STDOUT_FILENO,
+                  STDERR_FILENO};
+    char cbuf[CMSG_SPACE(sizeof(fds))];
+    memset(cbuf, 0, sizeof(cbuf));
+    struct iovec iov = {.iov_base = buf, .iov_len = len};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1,
+                         .msg_control = cbuf, .msg_controllen = sizeof(cbuf)};
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    pid_t pid = -1;
+    while (ready > 0 && pid < 0) {
+        struct zygote_s z = pool[--ready];
+        if (sendmsg(z.sock, &msg, MSG_NOSIGNAL) == (ssize_t)len) {
+            pid = z.pid;
+        } else { // el zygote murió: se descarta
+            waitpid(z.pid, NULL, 0);
+        }
+        close(z.sock);
+    }
+    free(buf);
+    return pid;
+}
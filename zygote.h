@@ -0,0 +1,50 @@
+/* Pool de procesos pre-forkeados ("zygotes") para lanzar comandos.
+ *
+ * Con `set -o zygote' el shell mantiene unos pocos procesos ya creados,
+ * bloqueados en un socketpair a la espera de un pedido. Para lanzar un
+ * comando se le manda a uno de ellos argv, el entorno, el directorio
+ * actual, las redirecciones y los descriptores de entrada/salida
+ * (SCM_RIGHTS); el zygote se conecta y hace exec. Así el fork queda fuera
+ * del camino crítico.
+ *
+ * Los zygotes no los forkea el shell sino un proceso maestro chico, creado
+ * al activar la opción, que los repone en segundo plano a medida que se
+ * usan. El maestro los crea con clone(CLONE_PARENT), así que son hijos
+ * directos del shell y se esperan con waitpid() igual que un fork. Cada
+ * zygote se usa una sola vez: el exec lo reemplaza.
+ */
+
+#ifndef _ZYGOTE_H_
+#define _ZYGOTE_H_
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include "command.h"
+#include "placement.h"
+
+pid_t zygote_spawn(scommand cmd, int in_fd, int out_fd, pid_t pgid, bool foreground,
+                   const placement_t *place);
+/*
+ * Lanza `cmd' en un proceso del pool, con la entrada en `in_fd' y la salida
+ * en `out_fd' (-1 para heredar las del shell) más las redirecciones de
+ * archivo de `cmd'. Los descriptores se duplican en el proceso lanzado, así
+ * que el llamador puede cerrarlos al volver. Antes del exec el proceso
+ * entra al grupo `pgid' y aplica `place', como placement_join_group() y
+ * placement_apply().
+ * Devuelve el pid del proceso, o -1 si no se pudo usar el pool (opción
+ * desactivada, pool vacío, pedido demasiado grande, o se llama desde un
+ * proceso hijo del dueño del pool); en ese caso hay que forkear como
+ * siempre.
+ *
+ * REQUIRES: cmd != NULL && !scommand_is_empty(cmd) && place != NULL
+ */
+
+void zygote_refill(void);
+/*
+ * Recoge los zygotes que el maestro ya tiene listos y le pide los que
+ * faltan para completar el pool, sin esperarlos; si la opción zygote está
+ * desactivada, cierra el pool y el maestro. El proceso que lo llama por
+ * primera vez queda como dueño del pool; en sus hijos no hace nada.
+ */
+
+#endif